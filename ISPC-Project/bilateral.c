@@ -0,0 +1,231 @@
+#include <math.h>
+#include <stdbool.h>
+
+#include "bilateral.h"
+#include "bilateral_ispc.h" // generated by ispc
+
+// Bilateral
+
+// tile size of the kernels, BILATERAL_TILE in bilateral.ispc
+#define BILATERAL_TILE 64
+
+static void VS_CC bilateralInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    BilateralData *d = (BilateralData *) * instanceData;
+    vsapi->setVideoInfo(d->vi, 1, node);
+}
+
+static const VSFrameRef *VS_CC bilateralGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    BilateralData *d = (BilateralData *) * instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+
+        float *tile = scratchPoolAcquire(d->pool);
+        if (!tile) {
+            vsapi->freeFrame(src);
+            vsapi->setFilterError("ispc.Bilateral: failed to allocate scratch buffer", frameCtx);
+            return 0;
+        }
+
+        float *num = tile + (BILATERAL_TILE + 2 * d->radius) * (BILATERAL_TILE + 2 * d->radius);
+        float *den = num + BILATERAL_TILE * BILATERAL_TILE;
+
+        const int pl[] = { 0, 1, 2 };
+        const VSFrameRef *fr[] = {d->process[0] ? NULL : src, d->process[1] ? NULL : src, d->process[2] ? NULL : src};
+        VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src, core);
+
+        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
+            if (d->process[plane]) {
+                int stride = vsapi->getStride(src, plane) / d->vi->format->bytesPerSample;
+                int height = vsapi->getFrameHeight(src, plane);
+                int width = vsapi->getFrameWidth(src, plane);
+                const uint8_t * VS_RESTRICT srcp = vsapi->getReadPtr(src, plane);
+                uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
+
+                if (d->vi->format->sampleType == stInteger) {
+                    const float peak = (float)((1 << d->vi->format->bitsPerSample) - 1);
+
+                    if (d->vi->format->bytesPerSample == 1) {
+                        bilateral_i8(srcp, dstp, tile, num, den, width, height, stride, d->radius, d->taps, d->offx, d->offy, d->spatial, d->lut, d->lut_max, d->range_scale, peak);
+
+                    } else if (d->vi->format->bytesPerSample == 2) {
+                        bilateral_i16((const uint16_t *)srcp, (uint16_t *)dstp, tile, num, den, width, height, stride, d->radius, d->taps, d->offx, d->offy, d->spatial, d->lut, d->lut_max, d->range_scale, peak);
+                    }
+                } else if (d->vi->format->sampleType == stFloat) {
+                    if (d->vi->format->bytesPerSample == 4) {
+                        bilateral_f32((const float *)srcp, (float *)dstp, tile, num, den, width, height, stride, d->radius, d->taps, d->offx, d->offy, d->spatial, d->lut, d->lut_max, d->range_scale, 1.f);
+                    }
+                }
+            }
+        }
+
+        scratchPoolRelease(d->pool, tile);
+
+        vsapi->freeFrame(src);
+        return dst;
+    }
+
+    return 0;
+}
+
+static void bilateralFreeTables(BilateralData *d) {
+    free(d->offx);
+    free(d->offy);
+    free(d->spatial);
+    free(d->lut);
+}
+
+static void VS_CC bilateralFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    BilateralData *d = (BilateralData *)instanceData;
+    vsapi->freeNode(d->node);
+    bilateralFreeTables(d);
+    scratchPoolFree(d->pool);
+    free(d);
+}
+
+void VS_CC bilateralCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    BilateralData d;
+
+    d.node = vsapi->propGetNode(in, "clip", 0, NULL);
+    d.vi = vsapi->getVideoInfo(d.node);
+
+    if (!isConstantFormat(d.vi) || d.vi->format->colorFamily == cmCompat) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Bilateral: only constant format input supported, and compat formats are not supported");
+        return;
+    }
+
+    if ((d.vi->format->sampleType == stInteger && d.vi->format->bytesPerSample != 1 && d.vi->format->bytesPerSample != 2)
+        || (d.vi->format->sampleType == stFloat && d.vi->format->bytesPerSample != 4)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Bilateral: only 8-16 bit integer and 32 bit float input supported");
+        return;
+    }
+
+    int err;
+
+    double sigma_s = vsapi->propGetFloat(in, "sigma_s", 0, &err);
+    if (err)
+        sigma_s = 3.0;
+
+    // the window is truncated at 3 sigma_s, and its padded tile must stay small enough for L2
+    if (sigma_s <= 0.0 || sigma_s > 21.0) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Bilateral: \"sigma_s\" must be greater than 0 and at most 21");
+        return;
+    }
+
+    double sigma_r = vsapi->propGetFloat(in, "sigma_r", 0, &err);
+    if (err)
+        sigma_r = 0.02;
+
+    if (sigma_r <= 0.0) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Bilateral: \"sigma_r\" must be greater than 0");
+        return;
+    }
+
+    int subsample = int64ToIntS(vsapi->propGetInt(in, "subsample", 0, &err));
+    if (err)
+        subsample = 1;
+
+    // a larger step would leave only the centre tap
+    if (subsample < 1 || subsample > (int)ceil(3.0 * sigma_s)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Bilateral: \"subsample\" must be between 1 and ceil(3 * sigma_s)");
+        return;
+    }
+
+    int num_planes = d.vi->format->numPlanes;
+    const int m = vsapi->propNumElements(in, "planes");
+
+    for (int i = 0; i < 3; i++)
+        d.process[i] = (m <= 0);
+
+    for (int i = 0; i < m; i++) {
+        int plane = int64ToIntS(vsapi->propGetInt(in, "planes", i, NULL));
+
+        if (plane < 0 || plane >= num_planes) {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Bilateral: plane index out of range");
+            return;
+        }
+
+        if (d.process[plane]) {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Bilateral: plane specified twice");
+            return;
+        }
+
+        d.process[plane] = true;
+    }
+
+    // spatial taps inside the circle of radius 3 sigma_s, every subsample pixels
+    const int steps = (int)ceil(3.0 * sigma_s) / subsample;
+    const int side = 2 * steps + 1;
+
+    d.radius = steps * subsample;
+    d.offx = malloc(side * side * sizeof(int32_t));
+    d.offy = malloc(side * side * sizeof(int32_t));
+    d.spatial = malloc(side * side * sizeof(float));
+    d.lut = NULL;
+    d.taps = 0;
+
+    if (!d.offx || !d.offy || !d.spatial) {
+        bilateralFreeTables(&d);
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Bilateral: failed to allocate tap tables");
+        return;
+    }
+
+    for (int y = -d.radius; y <= d.radius; y += subsample) {
+        for (int x = -d.radius; x <= d.radius; x += subsample) {
+            if (x * x + y * y <= d.radius * d.radius) {
+                d.offx[d.taps] = x;
+                d.offy[d.taps] = y;
+                d.spatial[d.taps] = (float)exp(-(x * x + y * y) / (2.0 * sigma_s * sigma_s));
+                d.taps++;
+            }
+        }
+    }
+
+    // range weights below exp(-18) are flushed to zero
+    d.lut_max = 0;
+    d.range_scale = (float)(-1.0 / (2.0 * sigma_r * sigma_r * log(2.0)));
+
+    if (d.vi->format->sampleType == stInteger) {
+        const int peak = (1 << d.vi->format->bitsPerSample) - 1;
+        const double s = sigma_r * peak;
+
+        d.lut_max = VSMIN((int)ceil(6.0 * s), peak);
+        d.lut = malloc((d.lut_max + 1) * sizeof(float));
+        if (!d.lut) {
+            bilateralFreeTables(&d);
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Bilateral: failed to allocate range weight table");
+            return;
+        }
+
+        for (int i = 0; i <= d.lut_max; i++)
+            d.lut[i] = (float)exp(-(double)i * i / (2.0 * s * s));
+
+        if (d.lut_max < peak)
+            d.lut[d.lut_max] = 0.f;
+    }
+
+    const size_t tile_size = (size_t)(BILATERAL_TILE + 2 * d.radius) * (BILATERAL_TILE + 2 * d.radius);
+    d.pool = scratchPoolCreate((tile_size + 2 * BILATERAL_TILE * BILATERAL_TILE) * sizeof(float));
+    if (!d.pool) {
+        bilateralFreeTables(&d);
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Bilateral: failed to allocate scratch pool");
+        return;
+    }
+
+    BilateralData * const data = malloc(sizeof(d));
+    *data = d;
+
+    vsapi->createFilter(in, out, "Bilateral", bilateralInit, bilateralGetFrame, bilateralFree, fmParallel, 0, data, core);
+}
@@ -0,0 +1,28 @@
+#ifndef ISPC_BILATERAL_H
+#define ISPC_BILATERAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "VapourSynth.h"
+#include "VSHelper.h"
+
+#include "scratch_pool.h"
+
+typedef struct {
+    VSNodeRef *node;
+    const VSVideoInfo *vi;
+    bool process[3];
+    int radius, taps;
+    int32_t *offx, *offy; // tap offsets, multiples of the subsampling step
+    float *spatial; // tap weights
+    float *lut; // range weights by absolute difference, integer formats only
+    int lut_max;
+    float range_scale; // float formats only
+    ScratchPool *pool; // tile, num and den arrays of the kernels
+} BilateralData;
+
+extern void VS_CC bilateralCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
+
+#endif // ISPC_BILATERAL_H
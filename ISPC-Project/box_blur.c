@@ -0,0 +1,210 @@
+#include <stdbool.h>
+
+#include "box_blur.h"
+#include "box_blur_ispc.h" // generated by ispc
+
+// BoxBlur
+
+// upper bound of programCount over the supported ispc targets, the kernels read up to programCount past the prefix sums
+#define BOX_BLUR_MAX_LANES 64
+
+// upper bound of the frame alignment of VapourSynth, strides are multiples of it
+#define BOX_BLUR_MAX_ALIGNMENT 64
+
+// bytes of the intermediate plane for multiple passes, sized for plane 0 (the largest plane) with the widest possible stride
+static size_t boxBlurPlaneSize(const VSVideoInfo *vi) {
+    const size_t row = ((size_t)vi->width * vi->format->bytesPerSample + BOX_BLUR_MAX_ALIGNMENT - 1) & ~(size_t)(BOX_BLUR_MAX_ALIGNMENT - 1);
+    return row * vi->height;
+}
+
+// bytes of the row, prefix and acc arrays, the float layout (double prefix sums and accumulators) is the largest
+static size_t boxBlurScratchSize(int width, int hradius) {
+    return sizeof(double) * ((size_t)width + 2 * (size_t)hradius + BOX_BLUR_MAX_LANES + 1 + (size_t)width);
+}
+
+static void VS_CC boxBlurInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    BoxBlurData *d = (BoxBlurData *) * instanceData;
+    vsapi->setVideoInfo(d->vi, 1, node);
+}
+
+static const VSFrameRef *VS_CC boxBlurGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    BoxBlurData *d = (BoxBlurData *) * instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+
+        // the intermediate plane (d->tmp_size bytes) followed by the row, prefix and acc arrays of the kernels
+        uint8_t *scratch = scratchPoolAcquire(d->pool);
+        if (!scratch) {
+            vsapi->freeFrame(src);
+            vsapi->setFilterError("ispc.BoxBlur: failed to allocate scratch buffer", frameCtx);
+            return 0;
+        }
+
+        if (d->tmp_size > 0 && (size_t)vsapi->getStride(src, 0) * vsapi->getFrameHeight(src, 0) > d->tmp_size) {
+            scratchPoolRelease(d->pool, scratch);
+            vsapi->freeFrame(src);
+            vsapi->setFilterError("ispc.BoxBlur: frame stride exceeds the intermediate plane", frameCtx);
+            return 0;
+        }
+
+        uint8_t *tmpp = (d->tmp_size > 0) ? scratch : NULL;
+        void *arrays = scratch + d->tmp_size;
+
+        const int pl[] = { 0, 1, 2 };
+        const VSFrameRef *fr[] = {d->process[0] ? NULL : src, d->process[1] ? NULL : src, d->process[2] ? NULL : src};
+        VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src, core);
+
+        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
+            if (d->process[plane]) {
+                int stride = vsapi->getStride(src, plane) / d->vi->format->bytesPerSample;
+                int height = vsapi->getFrameHeight(src, plane);
+                int width = vsapi->getFrameWidth(src, plane);
+                const uint8_t * VS_RESTRICT srcp = vsapi->getReadPtr(src, plane);
+                uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
+                const int prefix_size = width + 2 * d->hradius + BOX_BLUR_MAX_LANES + 1;
+
+                if (d->vi->format->sampleType == stInteger) {
+                    uint32_t *prefix = arrays;
+                    int32_t *row = (int32_t *)(prefix + prefix_size);
+                    int32_t *acc = row + width;
+
+                    if (d->vi->format->bytesPerSample == 1) {
+                        box_blur_i8(srcp, dstp, tmpp, row, prefix, acc, width, height, stride, d->hradius, d->hpasses, d->vradius, d->vpasses);
+
+                    } else if (d->vi->format->bytesPerSample == 2) {
+                        box_blur_i16((const uint16_t *)srcp, (uint16_t *)dstp, (uint16_t *)tmpp, row, prefix, acc, width, height, stride, d->hradius, d->hpasses, d->vradius, d->vpasses);
+                    }
+                } else if (d->vi->format->sampleType == stFloat) {
+                    double *prefix = arrays;
+                    double *acc = prefix + prefix_size;
+
+                    if (d->vi->format->bytesPerSample == 4) {
+                        box_blur_f32((const float *)srcp, (float *)dstp, (float *)tmpp, prefix, acc, width, height, stride, d->hradius, d->hpasses, d->vradius, d->vpasses);
+                    }
+                }
+            }
+        }
+
+        scratchPoolRelease(d->pool, scratch);
+
+        vsapi->freeFrame(src);
+        return dst;
+    }
+
+    return 0;
+}
+
+static void VS_CC boxBlurFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    BoxBlurData *d = (BoxBlurData *)instanceData;
+    vsapi->freeNode(d->node);
+    scratchPoolFree(d->pool);
+    free(d);
+}
+
+void VS_CC boxBlurCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    BoxBlurData d;
+
+    d.node = vsapi->propGetNode(in, "clip", 0, NULL);
+    d.vi = vsapi->getVideoInfo(d.node);
+
+    if (!isConstantFormat(d.vi) || d.vi->format->colorFamily == cmCompat) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.BoxBlur: only constant format input supported, and compat formats are not supported");
+        return;
+    }
+
+    if ((d.vi->format->sampleType == stInteger && d.vi->format->bytesPerSample != 1 && d.vi->format->bytesPerSample != 2)
+        || (d.vi->format->sampleType == stFloat && d.vi->format->bytesPerSample != 4)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.BoxBlur: only 8-16 bit integer and 32 bit float input supported");
+        return;
+    }
+
+    int err;
+
+    d.hradius = int64ToIntS(vsapi->propGetInt(in, "hradius", 0, &err));
+    if (err)
+        d.hradius = 1;
+
+    d.hpasses = int64ToIntS(vsapi->propGetInt(in, "hpasses", 0, &err));
+    if (err)
+        d.hpasses = 1;
+
+    d.vradius = int64ToIntS(vsapi->propGetInt(in, "vradius", 0, &err));
+    if (err)
+        d.vradius = 1;
+
+    d.vpasses = int64ToIntS(vsapi->propGetInt(in, "vpasses", 0, &err));
+    if (err)
+        d.vpasses = 1;
+
+    // integer window sums are divided exactly in single precision, which needs (2 * radius + 1) * 65535 < 2^24,
+    // float sums are accumulated in double and only bounded to keep the prefix arrays reasonable
+    const int max_radius = (d.vi->format->sampleType == stInteger) ? 127 : 65535;
+
+    if (d.hradius < 0 || d.hradius > max_radius || d.vradius < 0 || d.vradius > max_radius) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, (d.vi->format->sampleType == stInteger)
+            ? "ispc.BoxBlur: radius must be between 0 and 127 for integer input"
+            : "ispc.BoxBlur: radius must be between 0 and 65535 for float input");
+        return;
+    }
+
+    if (d.hpasses < 0 || d.vpasses < 0) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.BoxBlur: number of passes can't be negative");
+        return;
+    }
+
+    if (d.hradius == 0)
+        d.hpasses = 0;
+    if (d.vradius == 0)
+        d.vpasses = 0;
+
+    int num_planes = d.vi->format->numPlanes;
+    const int m = vsapi->propNumElements(in, "planes");
+
+    for (int i = 0; i < 3; i++)
+        d.process[i] = (m <= 0);
+
+    for (int i = 0; i < vsapi->propNumElements(in, "planes"); i++) {
+        int plane = int64ToIntS(vsapi->propGetInt(in, "planes", i, NULL));
+
+        if (plane < 0 || plane >= num_planes) {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.BoxBlur: plane index out of range");
+            return;
+        }
+
+        if (d.process[plane]) {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.BoxBlur: plane specified twice");
+            return;
+        }
+
+        d.process[plane] = true;
+    }
+
+    // nothing to blur, every plane is copied
+    if (d.hpasses == 0 && d.vpasses == 0) {
+        for (int i = 0; i < 3; i++)
+            d.process[i] = false;
+    }
+
+    // plane 0 is the largest plane, the intermediate plane is only needed for multiple passes
+    d.tmp_size = ((d.hpasses > 0) + d.vpasses > 1) ? boxBlurPlaneSize(d.vi) : 0;
+    d.pool = scratchPoolCreate(d.tmp_size + boxBlurScratchSize(d.vi->width, d.hradius));
+    if (!d.pool) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.BoxBlur: failed to allocate scratch pool");
+        return;
+    }
+
+    BoxBlurData * const data = malloc(sizeof(d));
+    *data = d;
+
+    vsapi->createFilter(in, out, "BoxBlur", boxBlurInit, boxBlurGetFrame, boxBlurFree, fmParallel, 0, data, core);
+}
@@ -0,0 +1,24 @@
+#ifndef ISPC_BOX_BLUR_H
+#define ISPC_BOX_BLUR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "VapourSynth.h"
+#include "VSHelper.h"
+
+#include "scratch_pool.h"
+
+typedef struct {
+    VSNodeRef *node;
+    const VSVideoInfo *vi;
+    bool process[3];
+    int hradius, hpasses, vradius, vpasses;
+    size_t tmp_size; // bytes of the intermediate plane at the start of each scratch buffer, 0 for a single pass
+    ScratchPool *pool;
+} BoxBlurData;
+
+extern void VS_CC boxBlurCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
+
+#endif // ISPC_BOX_BLUR_H
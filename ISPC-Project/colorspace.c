@@ -0,0 +1,469 @@
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "colorspace.h"
+#include "colorspace_ispc.h" // generated by ispc
+
+// Matrix
+static void VS_CC matrixInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    MatrixData *d = (MatrixData *) * instanceData;
+    vsapi->setVideoInfo(&d->out_vi, 1, node);
+}
+
+static const VSFrameRef *VS_CC matrixGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    MatrixData *d = (MatrixData *) * instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+
+        VSFrameRef *dst = vsapi->newVideoFrame(d->out_vi.format, d->out_vi.width, d->out_vi.height, src, core);
+
+        const VSFormat *fi = d->vi->format;
+        const VSFormat *fo = d->out_vi.format;
+
+        int src_stride = vsapi->getStride(src, 0) / fi->bytesPerSample;
+        int dst_stride = vsapi->getStride(dst, 0) / fo->bytesPerSample;
+        int height = vsapi->getFrameHeight(src, 0);
+        int width = vsapi->getFrameWidth(src, 0);
+        const uint8_t *srcp[3];
+        uint8_t *dstp[3];
+
+        for (int plane = 0; plane < 3; plane++) {
+            srcp[plane] = vsapi->getReadPtr(src, plane);
+            dstp[plane] = vsapi->getWritePtr(dst, plane);
+        }
+
+        if (fi->sampleType == stInteger && fi->bytesPerSample == 1) {
+            if (fo->sampleType == stInteger && fo->bytesPerSample == 1) {
+                matrix_i8_i8(srcp[0], srcp[1], srcp[2], dstp[0], dstp[1], dstp[2], 
+                    width, height, src_stride, dst_stride, d->coeffs, d->offsets, d->peak);
+            } else if (fo->sampleType == stInteger && fo->bytesPerSample == 2) {
+                matrix_i8_i16(srcp[0], srcp[1], srcp[2], (uint16_t *)dstp[0], (uint16_t *)dstp[1], (uint16_t *)dstp[2], 
+                    width, height, src_stride, dst_stride, d->coeffs, d->offsets, d->peak);
+            } else if (fo->sampleType == stFloat && fo->bytesPerSample == 4) {
+                matrix_i8_f32(srcp[0], srcp[1], srcp[2], (float *)dstp[0], (float *)dstp[1], (float *)dstp[2], 
+                    width, height, src_stride, dst_stride, d->coeffs, d->offsets, d->peak);
+            }
+        } else if (fi->sampleType == stInteger && fi->bytesPerSample == 2) {
+            const uint16_t *srcp0 = (const uint16_t *)srcp[0];
+            const uint16_t *srcp1 = (const uint16_t *)srcp[1];
+            const uint16_t *srcp2 = (const uint16_t *)srcp[2];
+
+            if (fo->sampleType == stInteger && fo->bytesPerSample == 1) {
+                matrix_i16_i8(srcp0, srcp1, srcp2, dstp[0], dstp[1], dstp[2], 
+                    width, height, src_stride, dst_stride, d->coeffs, d->offsets, d->peak);
+            } else if (fo->sampleType == stInteger && fo->bytesPerSample == 2) {
+                matrix_i16_i16(srcp0, srcp1, srcp2, (uint16_t *)dstp[0], (uint16_t *)dstp[1], (uint16_t *)dstp[2], 
+                    width, height, src_stride, dst_stride, d->coeffs, d->offsets, d->peak);
+            } else if (fo->sampleType == stFloat && fo->bytesPerSample == 4) {
+                matrix_i16_f32(srcp0, srcp1, srcp2, (float *)dstp[0], (float *)dstp[1], (float *)dstp[2], 
+                    width, height, src_stride, dst_stride, d->coeffs, d->offsets, d->peak);
+            }
+        } else if (fi->sampleType == stFloat && fi->bytesPerSample == 4) {
+            const float *srcp0 = (const float *)srcp[0];
+            const float *srcp1 = (const float *)srcp[1];
+            const float *srcp2 = (const float *)srcp[2];
+
+            if (fo->sampleType == stInteger && fo->bytesPerSample == 1) {
+                matrix_f32_i8(srcp0, srcp1, srcp2, dstp[0], dstp[1], dstp[2], 
+                    width, height, src_stride, dst_stride, d->coeffs, d->offsets, d->peak);
+            } else if (fo->sampleType == stInteger && fo->bytesPerSample == 2) {
+                matrix_f32_i16(srcp0, srcp1, srcp2, (uint16_t *)dstp[0], (uint16_t *)dstp[1], (uint16_t *)dstp[2], 
+                    width, height, src_stride, dst_stride, d->coeffs, d->offsets, d->peak);
+            } else if (fo->sampleType == stFloat && fo->bytesPerSample == 4) {
+                matrix_f32_f32(srcp0, srcp1, srcp2, (float *)dstp[0], (float *)dstp[1], (float *)dstp[2], 
+                    width, height, src_stride, dst_stride, d->coeffs, d->offsets, d->peak);
+            }
+        }
+
+        vsapi->freeFrame(src);
+        return dst;
+    }
+
+    return 0;
+}
+
+static void VS_CC matrixFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    MatrixData *d = (MatrixData *)instanceData;
+    vsapi->freeNode(d->node);
+    free(d);
+}
+
+// normalized = raw * scale + shift, where luma and RGB span [0, 1] and chroma spans [-0.5, 0.5]
+static void planeNormalization(const VSFormat *f, int plane, bool full_range, double *scale, double *shift) {
+    const bool chroma = (plane > 0) && (f->colorFamily == cmYUV || f->colorFamily == cmYCoCg);
+
+    if (f->sampleType == stFloat) {
+        *scale = 1.0;
+        *shift = 0.0;
+    } else if (full_range) {
+        *scale = 1.0 / ((1 << f->bitsPerSample) - 1);
+        *shift = chroma ? -(1 << (f->bitsPerSample - 1)) * *scale : 0.0;
+    } else {
+        const double unit = 1 << (f->bitsPerSample - 8);
+        *scale = 1.0 / ((chroma ? 224.0 : 219.0) * unit);
+        *shift = -(chroma ? 128.0 : 16.0) * unit * *scale;
+    }
+}
+
+static bool isSupportedMatrixFormat(const VSFormat *f) {
+    return f->numPlanes == 3 && f->subSamplingW == 0 && f->subSamplingH == 0 && f->colorFamily != cmCompat
+        && ((f->sampleType == stInteger && (f->bytesPerSample == 1 || f->bytesPerSample == 2))
+            || (f->sampleType == stFloat && f->bytesPerSample == 4));
+}
+
+void VS_CC matrixCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    MatrixData d;
+
+    d.node = vsapi->propGetNode(in, "clip", 0, NULL);
+    d.vi = vsapi->getVideoInfo(d.node);
+
+    if (!isConstantFormat(d.vi) || !isSupportedMatrixFormat(d.vi->format)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Matrix: only constant format 4:4:4 YUV, RGB and YCoCg input with 8-16 bit integer or 32 bit float samples supported");
+        return;
+    }
+
+    int err;
+
+    const char *preset = vsapi->propGetData(in, "matrix", 0, &err);
+    if (err)
+        preset = NULL;
+
+    const int num_coeffs = vsapi->propNumElements(in, "coeffs");
+
+    if ((preset == NULL) == (num_coeffs <= 0)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Matrix: exactly one of \"matrix\" and \"coeffs\" must be specified");
+        return;
+    }
+
+    const VSFormat *fi = d.vi->format;
+    const VSFormat *fo;
+
+    int format_id = int64ToIntS(vsapi->propGetInt(in, "format", 0, &err));
+    if (err) {
+        int family;
+        if (fi->colorFamily == cmRGB)
+            family = (preset != NULL && strcmp(preset, "ycocg") == 0) ? cmYCoCg : cmYUV;
+        else
+            family = cmRGB;
+
+        fo = vsapi->registerFormat(family, fi->sampleType, fi->bitsPerSample, 0, 0, core);
+    } else {
+        fo = vsapi->getFormatPreset(format_id, core);
+    }
+
+    if (fo == NULL || !isSupportedMatrixFormat(fo)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Matrix: only 4:4:4 YUV, RGB and YCoCg output with 8-16 bit integer or 32 bit float samples supported");
+        return;
+    }
+
+    // matrix on normalized values, out = m * in
+    double m[9];
+
+    if (preset != NULL) {
+        if (strcmp(preset, "ycocg") == 0) {
+            static const double rgb_to_ycocg[9] = {
+                 0.25, 0.5,  0.25,
+                 0.5,  0.0, -0.5,
+                -0.25, 0.5, -0.25
+            };
+            static const double ycocg_to_rgb[9] = {
+                1.0,  1.0, -1.0,
+                1.0,  0.0,  1.0,
+                1.0, -1.0, -1.0
+            };
+
+            if (fi->colorFamily == cmRGB && fo->colorFamily == cmYCoCg) {
+                memcpy(m, rgb_to_ycocg, sizeof(m));
+            } else if (fi->colorFamily == cmYCoCg && fo->colorFamily == cmRGB) {
+                memcpy(m, ycocg_to_rgb, sizeof(m));
+            } else {
+                vsapi->freeNode(d.node);
+                vsapi->setError(out, "ispc.Matrix: \"ycocg\" converts between RGB and YCoCg");
+                return;
+            }
+        } else {
+            double kr, kb;
+
+            if (strcmp(preset, "601") == 0) {
+                kr = 0.299;
+                kb = 0.114;
+            } else if (strcmp(preset, "709") == 0) {
+                kr = 0.2126;
+                kb = 0.0722;
+            } else if (strcmp(preset, "2020") == 0) {
+                kr = 0.2627;
+                kb = 0.0593;
+            } else {
+                vsapi->freeNode(d.node);
+                vsapi->setError(out, "ispc.Matrix: \"matrix\" must be one of \"601\", \"709\", \"2020\" or \"ycocg\"");
+                return;
+            }
+
+            const double kg = 1.0 - kr - kb;
+
+            if (fi->colorFamily == cmRGB && fo->colorFamily == cmYUV) {
+                const double rgb_to_yuv[9] = {
+                    kr, kg, kb,
+                    -kr / (2.0 * (1.0 - kb)), -kg / (2.0 * (1.0 - kb)), 0.5,
+                    0.5, -kg / (2.0 * (1.0 - kr)), -kb / (2.0 * (1.0 - kr))
+                };
+                memcpy(m, rgb_to_yuv, sizeof(m));
+            } else if (fi->colorFamily == cmYUV && fo->colorFamily == cmRGB) {
+                const double yuv_to_rgb[9] = {
+                    1.0, 0.0, 2.0 * (1.0 - kr),
+                    1.0, -2.0 * kb * (1.0 - kb) / kg, -2.0 * kr * (1.0 - kr) / kg,
+                    1.0, 2.0 * (1.0 - kb), 0.0
+                };
+                memcpy(m, yuv_to_rgb, sizeof(m));
+            } else {
+                vsapi->freeNode(d.node);
+                vsapi->setError(out, "ispc.Matrix: matrix presets convert between YUV and RGB");
+                return;
+            }
+        }
+    } else {
+        if (num_coeffs != 9) {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Matrix: \"coeffs\" must have 9 values");
+            return;
+        }
+
+        for (int i = 0; i < 9; i++)
+            m[i] = vsapi->propGetFloat(in, "coeffs", i, NULL);
+    }
+
+    if (vsapi->propNumElements(in, "offsets") > 3) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Matrix: \"offsets\" has more values specified than there are planes");
+        return;
+    }
+
+    double offsets[3];
+    for (int i = 0; i < 3; i++) {
+        offsets[i] = vsapi->propGetFloat(in, "offsets", i, &err);
+        if (err)
+            offsets[i] = 0.0;
+    }
+
+    // integer YUV defaults to limited range, everything else to full range
+    bool full_in = !!vsapi->propGetInt(in, "full_in", 0, &err);
+    if (err)
+        full_in = fi->colorFamily != cmYUV;
+
+    bool full_out = !!vsapi->propGetInt(in, "full_out", 0, &err);
+    if (err)
+        full_out = fo->colorFamily != cmYUV;
+
+    // raw_out[r] = (sum_k m[r][k] * (raw_in[k] * si[k] + ti[k]) + offsets[r] - to[r]) / so[r]
+    double si[3], ti[3], so[3], to[3];
+    for (int plane = 0; plane < 3; plane++) {
+        planeNormalization(fi, plane, full_in, &si[plane], &ti[plane]);
+        planeNormalization(fo, plane, full_out, &so[plane], &to[plane]);
+    }
+
+    for (int r = 0; r < 3; r++) {
+        double shift = offsets[r] - to[r];
+
+        for (int k = 0; k < 3; k++) {
+            d.coeffs[r * 3 + k] = (float)(m[r * 3 + k] * si[k] / so[r]);
+            shift += m[r * 3 + k] * ti[k];
+        }
+
+        d.offsets[r] = (float)(shift / so[r]);
+    }
+
+    d.peak = (fo->sampleType == stInteger) ? (float)((1 << fo->bitsPerSample) - 1) : 0.f;
+
+    d.out_vi = *d.vi;
+    d.out_vi.format = fo;
+
+    MatrixData * const data = malloc(sizeof(d));
+    *data = d;
+
+    vsapi->createFilter(in, out, "Matrix", matrixInit, matrixGetFrame, matrixFree, fmParallel, 0, data, core);
+}
+
+// Transfer
+static const double st2084_m1 = 2610.0 / 16384.0;
+static const double st2084_m2 = 2523.0 / 4096.0 * 128.0;
+static const double st2084_c1 = 3424.0 / 4096.0;
+static const double st2084_c2 = 2413.0 / 4096.0 * 32.0;
+static const double st2084_c3 = 2392.0 / 4096.0 * 32.0;
+
+static const double hlg_a = 0.17883277;
+static const double hlg_b = 0.28466892;
+static const double hlg_c = 0.55991072952956202016; // 0.5 - a * ln(4 * a)
+
+static const double bt709_alpha = 1.09929682680944;
+static const double bt709_beta = 0.018053968510807;
+
+static double toLinear(double x, TransferFunction transfer) {
+    x = VSMAX(x, 0.0);
+
+    switch (transfer) {
+    case kTransferSRGB:
+        return (x <= 0.04045) ? x / 12.92 : pow((x + 0.055) / 1.055, 2.4);
+    case kTransferBT1886:
+        return pow(x, 2.4);
+    case kTransferBT709:
+        return (x < 4.5 * bt709_beta) ? x / 4.5 : pow((x + (bt709_alpha - 1.0)) / bt709_alpha, 1.0 / 0.45);
+    case kTransferST2084: {
+        const double p = pow(VSMIN(x, 1.0), 1.0 / st2084_m2);
+        return pow(VSMAX(p - st2084_c1, 0.0) / (st2084_c2 - st2084_c3 * p), 1.0 / st2084_m1);
+    }
+    case kTransferHLG:
+        return (x <= 0.5) ? x * x / 3.0 : (exp((x - hlg_c) / hlg_a) + hlg_b) / 12.0;
+    default:
+        return x;
+    }
+}
+
+static double fromLinear(double x, TransferFunction transfer) {
+    x = VSMAX(x, 0.0);
+
+    switch (transfer) {
+    case kTransferSRGB:
+        return (x <= 0.0031308) ? x * 12.92 : 1.055 * pow(x, 1.0 / 2.4) - 0.055;
+    case kTransferBT1886:
+        return pow(x, 1.0 / 2.4);
+    case kTransferBT709:
+        return (x < bt709_beta) ? x * 4.5 : bt709_alpha * pow(x, 0.45) - (bt709_alpha - 1.0);
+    case kTransferST2084: {
+        const double y = pow(VSMIN(x, 1.0), st2084_m1);
+        return pow((st2084_c1 + st2084_c2 * y) / (1.0 + st2084_c3 * y), st2084_m2);
+    }
+    case kTransferHLG:
+        return (x <= 1.0 / 12.0) ? sqrt(3.0 * x) : hlg_a * log(12.0 * x - hlg_b) + hlg_c;
+    default:
+        return x;
+    }
+}
+
+static bool parseTransfer(const char *name, TransferFunction *transfer) {
+    static const char * const names[] = { "linear", "srgb", "1886", "709", "st2084", "hlg" };
+
+    for (int i = 0; i < 6; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *transfer = (TransferFunction)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void VS_CC transferInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    TransferData *d = (TransferData *) * instanceData;
+    vsapi->setVideoInfo(d->vi, 1, node);
+}
+
+static const VSFrameRef *VS_CC transferGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    TransferData *d = (TransferData *) * instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+
+        VSFrameRef *dst = vsapi->newVideoFrame(d->vi->format, d->vi->width, d->vi->height, src, core);
+
+        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
+            int stride = vsapi->getStride(src, plane) / d->vi->format->bytesPerSample;
+            int height = vsapi->getFrameHeight(src, plane);
+            int width = vsapi->getFrameWidth(src, plane);
+            const uint8_t * VS_RESTRICT srcp = vsapi->getReadPtr(src, plane);
+            uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
+
+            if (d->vi->format->sampleType == stInteger) {
+                if (d->vi->format->bytesPerSample == 1) {
+                    transfer_lut_i8(srcp, dstp, width, height, stride, (const uint8_t *)d->lut);
+
+                } else if (d->vi->format->bytesPerSample == 2) {
+                    transfer_lut_i16((const uint16_t *)srcp, (uint16_t *)dstp, width, height, stride, (const uint16_t *)d->lut);
+                }
+            } else if (d->vi->format->sampleType == stFloat) {
+                if (d->vi->format->bytesPerSample == 4) {
+                    transfer_f32((const float *)srcp, (float *)dstp, width, height, stride, d->transfer_in, d->transfer_out);
+                }
+            }
+        }
+
+        vsapi->freeFrame(src);
+        return dst;
+    }
+
+    return 0;
+}
+
+static void VS_CC transferFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    TransferData *d = (TransferData *)instanceData;
+    vsapi->freeNode(d->node);
+    free(d->lut);
+    free(d);
+}
+
+void VS_CC transferCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    TransferData d;
+
+    d.node = vsapi->propGetNode(in, "clip", 0, NULL);
+    d.vi = vsapi->getVideoInfo(d.node);
+
+    if (!isConstantFormat(d.vi) || (d.vi->format->colorFamily != cmGray && d.vi->format->colorFamily != cmRGB)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Transfer: only constant format Gray and RGB input supported");
+        return;
+    }
+
+    if ((d.vi->format->sampleType == stInteger && d.vi->format->bytesPerSample != 1 && d.vi->format->bytesPerSample != 2)
+        || (d.vi->format->sampleType == stFloat && d.vi->format->bytesPerSample != 4)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Transfer: only 8-16 bit integer and 32 bit float input supported");
+        return;
+    }
+
+    if (!parseTransfer(vsapi->propGetData(in, "transfer_in", 0, NULL), &d.transfer_in) 
+        || !parseTransfer(vsapi->propGetData(in, "transfer_out", 0, NULL), &d.transfer_out)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Transfer: transfer must be one of \"linear\", \"srgb\", \"1886\", \"709\", \"st2084\" or \"hlg\"");
+        return;
+    }
+
+    d.lut = NULL;
+
+    if (d.vi->format->sampleType == stInteger) {
+        // covers every representable sample value, so out-of-range input never reads past the table
+        const int lut_size = 1 << (8 * d.vi->format->bytesPerSample);
+        const double peak = (1 << d.vi->format->bitsPerSample) - 1;
+
+        d.lut = malloc(lut_size * d.vi->format->bytesPerSample);
+        if (!d.lut) {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Transfer: failed to allocate lookup table");
+            return;
+        }
+
+        for (int v = 0; v < lut_size; v++) {
+            const double x = VSMIN(v / peak, 1.0);
+            const double y = fromLinear(toLinear(x, d.transfer_in), d.transfer_out) * peak + 0.5;
+            const int value = (int)VSMAX(VSMIN(y, peak), 0.0);
+
+            if (d.vi->format->bytesPerSample == 1) {
+                ((uint8_t *)d.lut)[v] = (uint8_t)value;
+            } else {
+                ((uint16_t *)d.lut)[v] = (uint16_t)value;
+            }
+        }
+    }
+
+    TransferData * const data = malloc(sizeof(d));
+    *data = d;
+
+    vsapi->createFilter(in, out, "Transfer", transferInit, transferGetFrame, transferFree, fmParallel, 0, data, core);
+}
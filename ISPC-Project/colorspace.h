@@ -0,0 +1,41 @@
+#ifndef ISPC_COLORSPACE_H
+#define ISPC_COLORSPACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "VapourSynth.h"
+#include "VSHelper.h"
+
+typedef struct {
+    VSNodeRef *node;
+    const VSVideoInfo *vi;
+    VSVideoInfo out_vi;
+    float coeffs[9]; // applied to raw sample values, row-major
+    float offsets[3];
+    float peak;
+} MatrixData;
+
+extern void VS_CC matrixCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
+
+// must match the TRANSFER_* values of colorspace.ispc
+typedef enum TransferFunction {
+    kTransferLinear = 0,
+    kTransferSRGB = 1,
+    kTransferBT1886 = 2,
+    kTransferBT709 = 3,
+    kTransferST2084 = 4,
+    kTransferHLG = 5
+} TransferFunction;
+
+typedef struct {
+    VSNodeRef *node;
+    const VSVideoInfo *vi;
+    TransferFunction transfer_in, transfer_out;
+    void *lut; // integer input only
+} TransferData;
+
+extern void VS_CC transferCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
+
+#endif // ISPC_COLORSPACE_H
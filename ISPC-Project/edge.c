@@ -0,0 +1,289 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "edge.h"
+#include "edge_ispc.h" // generated by ispc
+
+// Sobel, Prewitt
+static void VS_CC edgeInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    EdgeData *d = (EdgeData *) * instanceData;
+    vsapi->setVideoInfo(d->vi, 1, node);
+}
+
+static const VSFrameRef *VS_CC edgeGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    EdgeData *d = (EdgeData *) * instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+
+        const int pl[] = { 0, 1, 2 };
+        const VSFrameRef *fr[] = {d->process[0] ? NULL : src, d->process[1] ? NULL : src, d->process[2] ? NULL : src};
+        VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src, core);
+
+        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
+            if (d->process[plane]) {
+                int stride = vsapi->getStride(src, plane) / d->vi->format->bytesPerSample;
+                int height = vsapi->getFrameHeight(src, plane);
+                int width = vsapi->getFrameWidth(src, plane);
+                const uint8_t * VS_RESTRICT srcp = vsapi->getReadPtr(src, plane);
+                uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
+
+                if (d->vi->format->sampleType == stInteger) {
+                    const int peak = (1 << d->vi->format->bitsPerSample) - 1;
+
+                    if (d->vi->format->bytesPerSample == 1) {
+                        edge_i8(srcp, dstp, width, height, stride, d->weight, d->scale, d->approximate, d->scale_q, d->limit, peak);
+
+                    } else if (d->vi->format->bytesPerSample == 2) {
+                        edge_i16((const uint16_t *)srcp, (uint16_t *)dstp, width, height, stride, d->weight, d->scale, d->approximate, d->scale_q, d->limit, peak);
+                    }
+                } else if (d->vi->format->sampleType == stFloat) {
+                    if (d->vi->format->bytesPerSample == 4) {
+                        edge_f32((const float *)srcp, (float *)dstp, width, height, stride, (float)d->weight, d->scale);
+                    }
+                }
+            }
+        }
+
+        vsapi->freeFrame(src);
+        return dst;
+    }
+
+    return 0;
+}
+
+static void VS_CC edgeFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    EdgeData *d = (EdgeData *)instanceData;
+    vsapi->freeNode(d->node);
+    free(d);
+}
+
+static void edgeCreate(const VSMap *in, VSMap *out, VSCore *core, const VSAPI *vsapi, const char *name, int weight) {
+    EdgeData d;
+    char msg[128];
+
+    d.node = vsapi->propGetNode(in, "clip", 0, NULL);
+    d.vi = vsapi->getVideoInfo(d.node);
+    d.weight = weight;
+
+    if (!isConstantFormat(d.vi) || d.vi->format->colorFamily == cmCompat) {
+        vsapi->freeNode(d.node);
+        snprintf(msg, sizeof(msg), "ispc.%s: only constant format input supported, and compat formats are not supported", name);
+        vsapi->setError(out, msg);
+        return;
+    }
+
+    if ((d.vi->format->sampleType == stInteger && d.vi->format->bytesPerSample != 1 && d.vi->format->bytesPerSample != 2)
+        || (d.vi->format->sampleType == stFloat && d.vi->format->bytesPerSample != 4)) {
+        vsapi->freeNode(d.node);
+        snprintf(msg, sizeof(msg), "ispc.%s: only 8-16 bit integer and 32 bit float input supported", name);
+        vsapi->setError(out, msg);
+        return;
+    }
+
+    int err;
+
+    d.scale = (float)vsapi->propGetFloat(in, "scale", 0, &err);
+    if (err)
+        d.scale = 1.f;
+
+    // the upper bound keeps scale * 4096 within the 4.12 fixed point range of int32
+    if (!(d.scale > 0.f && d.scale <= 65535.f)) {
+        vsapi->freeNode(d.node);
+        snprintf(msg, sizeof(msg), "ispc.%s: \"scale\" must be greater than 0 and at most 65535", name);
+        vsapi->setError(out, msg);
+        return;
+    }
+
+    d.approximate = !!vsapi->propGetInt(in, "approximate", 0, &err);
+    if (err)
+        d.approximate = false;
+
+    if (d.approximate && d.vi->format->sampleType != stInteger) {
+        vsapi->freeNode(d.node);
+        snprintf(msg, sizeof(msg), "ispc.%s: \"approximate\" is only available for integer input", name);
+        vsapi->setError(out, msg);
+        return;
+    }
+
+    // scale in 4.12 fixed point, and the largest unscaled magnitude that can't saturate the output
+    d.scale_q = VSMAX((int32_t)(d.scale * 4096.f + 0.5f), 1);
+    if (d.vi->format->sampleType == stInteger)
+        d.limit = (int32_t)(((int64_t)1 << (d.vi->format->bitsPerSample + 12)) / d.scale_q + 1);
+    else
+        d.limit = 0;
+
+    int num_planes = d.vi->format->numPlanes;
+    const int m = vsapi->propNumElements(in, "planes");
+
+    for (int i = 0; i < 3; i++)
+        d.process[i] = (m <= 0);
+
+    for (int i = 0; i < vsapi->propNumElements(in, "planes"); i++) {
+        int plane = int64ToIntS(vsapi->propGetInt(in, "planes", i, NULL));
+
+        if (plane < 0 || plane >= num_planes) {
+            vsapi->freeNode(d.node);
+            snprintf(msg, sizeof(msg), "ispc.%s: plane index out of range", name);
+            vsapi->setError(out, msg);
+            return;
+        }
+
+        if (d.process[plane]) {
+            vsapi->freeNode(d.node);
+            snprintf(msg, sizeof(msg), "ispc.%s: plane specified twice", name);
+            vsapi->setError(out, msg);
+            return;
+        }
+
+        d.process[plane] = true;
+    }
+
+    EdgeData * const data = malloc(sizeof(d));
+    *data = d;
+
+    vsapi->createFilter(in, out, name, edgeInit, edgeGetFrame, edgeFree, fmParallel, 0, data, core);
+}
+
+void VS_CC sobelCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    edgeCreate(in, out, core, vsapi, "Sobel", 2);
+}
+
+void VS_CC prewittCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    edgeCreate(in, out, core, vsapi, "Prewitt", 1);
+}
+
+// Hysteresis
+static void VS_CC hysteresisInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    HysteresisData *d = (HysteresisData *) * instanceData;
+    vsapi->setVideoInfo(d->vi, 1, node);
+}
+
+static const VSFrameRef *VS_CC hysteresisGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    HysteresisData *d = (HysteresisData *) * instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node1, frameCtx);
+        vsapi->requestFrameFilter(n, d->node2, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrameRef *src1 = vsapi->getFrameFilter(n, d->node1, frameCtx);
+        const VSFrameRef *src2 = vsapi->getFrameFilter(n, d->node2, frameCtx);
+
+        const int pl[] = { 0, 1, 2 };
+        const VSFrameRef *fr[] = { d->process[0] ? NULL : src1, d->process[1] ? NULL : src1, d->process[2] ? NULL : src1 };
+        VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src1, core);
+
+        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
+            if (d->process[plane]) {
+                int stride = vsapi->getStride(src1, plane) / d->vi->format->bytesPerSample;
+                int height = vsapi->getFrameHeight(src1, plane);
+                int width = vsapi->getFrameWidth(src1, plane);
+                const uint8_t * VS_RESTRICT srcp1 = vsapi->getReadPtr(src1, plane);
+                const uint8_t * VS_RESTRICT srcp2 = vsapi->getReadPtr(src2, plane);
+                uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
+
+                if (d->vi->format->sampleType == stInteger) {
+                    if (d->vi->format->bytesPerSample == 1) {
+                        hysteresis_i8(srcp1, srcp2, dstp, width, height, stride, (uint8_t)d->lower[plane], (uint8_t)d->upper[plane]);
+
+                    } else if (d->vi->format->bytesPerSample == 2) {
+                        hysteresis_i16((const uint16_t *)srcp1, (const uint16_t *)srcp2, (uint16_t *)dstp, width, height, stride, (uint16_t)d->lower[plane], (uint16_t)d->upper[plane]);
+                    }
+                } else if (d->vi->format->sampleType == stFloat) {
+                    if (d->vi->format->bytesPerSample == 4) {
+                        hysteresis_f32((const float *)srcp1, (const float *)srcp2, (float *)dstp, width, height, stride, d->lower[plane], d->upper[plane]);
+                    }
+                }
+            }
+        }
+
+        vsapi->freeFrame(src1);
+        vsapi->freeFrame(src2);
+        return dst;
+    }
+
+    return 0;
+}
+
+static void VS_CC hysteresisFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    HysteresisData *d = (HysteresisData *)instanceData;
+    vsapi->freeNode(d->node1);
+    vsapi->freeNode(d->node2);
+    free(d);
+}
+
+void VS_CC hysteresisCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    HysteresisData d;
+
+    d.node1 = vsapi->propGetNode(in, "clipa", 0, NULL);
+    d.node2 = vsapi->propGetNode(in, "clipb", 0, NULL);
+    d.vi = vsapi->getVideoInfo(d.node1);
+
+    if (!isConstantFormat(d.vi) || !isSameFormat(d.vi, vsapi->getVideoInfo(d.node2))) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        vsapi->setError(out, "ispc.Hysteresis: both clips must have constant format and dimensions, and the same format and dimensions");
+        return;
+    }
+
+    if (d.vi->format->colorFamily == cmCompat) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        vsapi->setError(out, "ispc.Hysteresis: compat formats are not supported");
+        return;
+    }
+
+    if ((d.vi->format->sampleType == stInteger && d.vi->format->bytesPerSample != 1 && d.vi->format->bytesPerSample != 2)
+        || (d.vi->format->sampleType == stFloat && d.vi->format->bytesPerSample != 4)) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        vsapi->setError(out, "ispc.Hysteresis: only 8-16 bit integer and 32 bit float input supported");
+        return;
+    }
+
+    int num_planes = d.vi->format->numPlanes;
+    const int m = vsapi->propNumElements(in, "planes");
+
+    for (int i = 0; i < 3; i++)
+        d.process[i] = (m <= 0);
+
+    for (int i = 0; i < m; i++) {
+        int plane = int64ToIntS(vsapi->propGetInt(in, "planes", i, NULL));
+
+        if (plane < 0 || plane >= num_planes) {
+            vsapi->freeNode(d.node1);
+            vsapi->freeNode(d.node2);
+            vsapi->setError(out, "ispc.Hysteresis: plane index out of range");
+            return;
+        }
+
+        if (d.process[plane]) {
+            vsapi->freeNode(d.node1);
+            vsapi->freeNode(d.node2);
+            vsapi->setError(out, "ispc.Hysteresis: plane specified twice");
+            return;
+        }
+
+        d.process[plane] = true;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        if (d.vi->format->sampleType == stInteger) {
+            d.lower[i] = 0.f;
+            d.upper[i] = (float)((1 << d.vi->format->bitsPerSample) - 1);
+        } else if (i > 0 && (d.vi->format->colorFamily == cmYUV || d.vi->format->colorFamily == cmYCoCg)) {
+            d.lower[i] = -0.5f;
+            d.upper[i] = 0.5f;
+        } else {
+            d.lower[i] = 0.f;
+            d.upper[i] = 1.f;
+        }
+    }
+
+    HysteresisData * const data = malloc(sizeof(d));
+    *data = d;
+
+    vsapi->createFilter(in, out, "Hysteresis", hysteresisInit, hysteresisGetFrame, hysteresisFree, fmParallel, 0, data, core);
+}
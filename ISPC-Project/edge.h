@@ -0,0 +1,34 @@
+#ifndef ISPC_EDGE_H
+#define ISPC_EDGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "VapourSynth.h"
+#include "VSHelper.h"
+
+typedef struct {
+    VSNodeRef *node;
+    const VSVideoInfo *vi;
+    bool process[3];
+    int weight; // centre tap, 2 for Sobel and 1 for Prewitt
+    float scale;
+    bool approximate;
+    int32_t scale_q, limit; // approximate mode only
+} EdgeData;
+
+extern void VS_CC sobelCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
+extern void VS_CC prewittCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
+
+typedef struct {
+    VSNodeRef *node1;
+    VSNodeRef *node2;
+    const VSVideoInfo *vi;
+    bool process[3];
+    float lower[3], upper[3]; // mask threshold and output values, as in misc.Hysteresis
+} HysteresisData;
+
+extern void VS_CC hysteresisCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
+
+#endif // ISPC_EDGE_H
@@ -1,8 +1,59 @@
+#include <math.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "element_wise.h"
 #include "element_wise_ispc.h" // generated by ispc
 
+// Whole-frame dispatch
+// Plane pointers and dimensions of every processed plane are gathered into one FrameArgs,
+// so that a single ISPC call processes the whole frame.
+typedef void (*FrameFunc)(const struct FrameArgs *args);
+
+static void setFramePlanes(struct FrameArgs *args, const VSFrameRef *src1, const VSFrameRef *src2, VSFrameRef *dst, 
+                           const bool process[3], const VSVideoInfo *vi, const VSAPI *vsapi) {
+    const VSFormat *fi = vi->format;
+
+    args->num_planes = fi->numPlanes;
+    args->peak = (fi->sampleType == stInteger) ? (1 << fi->bitsPerSample) - 1 : 0;
+    args->halfpoint = (fi->sampleType == stInteger) ? 1 << (fi->bitsPerSample - 1) : 0;
+
+    for (int plane = 0; plane < 3; plane++) {
+        args->process[plane] = (plane < fi->numPlanes) && process[plane];
+        args->uv[plane] = (plane > 0) && ((fi->colorFamily == cmYUV) || (fi->colorFamily == cmYCoCg));
+        args->srcp1[plane] = NULL;
+        args->srcp2[plane] = NULL;
+        args->dstp[plane] = NULL;
+        args->width[plane] = 0;
+        args->height[plane] = 0;
+        args->stride[plane] = 0;
+
+        if (args->process[plane]) {
+            args->srcp1[plane] = vsapi->getReadPtr(src1, plane);
+            args->srcp2[plane] = src2 ? vsapi->getReadPtr(src2, plane) : NULL;
+            args->dstp[plane] = vsapi->getWritePtr(dst, plane);
+            args->width[plane] = vi->width >> (plane ? fi->subSamplingW : 0);
+            args->height[plane] = vi->height >> (plane ? fi->subSamplingH : 0);
+            args->stride[plane] = vsapi->getStride(src1, plane) / fi->bytesPerSample;
+        }
+    }
+}
+
+static void runFrame(const struct FrameArgs *args, const VSFormat *fi, FrameFunc func_i8, FrameFunc func_i16, FrameFunc func_f32) {
+    if (fi->sampleType == stInteger) {
+        if (fi->bytesPerSample == 1) {
+            func_i8(args);
+        } else if (fi->bytesPerSample == 2) {
+            func_i16(args);
+        }
+    } else if (fi->sampleType == stFloat) {
+        if (fi->bytesPerSample == 4) {
+            func_f32(args);
+        }
+    }
+}
+
 // Invert
 static void VS_CC invertInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
     InvertData *d = (InvertData *) * instanceData;
@@ -21,36 +72,10 @@ static const VSFrameRef *VS_CC invertGetFrame(int n, int activationReason, void
         const VSFrameRef *fr[] = {d->process[0] ? NULL : src, d->process[1] ? NULL : src, d->process[2] ? NULL : src};
         VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src, core);
 
-        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
-            if (d->process[plane]) {
-                int stride = vsapi->getStride(src, plane) / d->vi->format->bytesPerSample;
-                int height = vsapi->getFrameHeight(src, plane);
-                int width = vsapi->getFrameWidth(src, plane);
-                const uint8_t * VS_RESTRICT srcp = vsapi->getReadPtr(src, plane);
-                uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
-
-                if (d->vi->format->sampleType == stInteger) {
-                    if (d->vi->format->bytesPerSample == 1) {
-                        invert_i8(srcp, dstp, width, height, stride);
-
-                    } else if (d->vi->format->bytesPerSample == 2) {
-                        if (d->vi->format->bitsPerSample == 16) {
-                            invert_i16((const uint16_t *)srcp, (uint16_t *)dstp, width, height, stride);
-                        } else {
-                            const uint16_t peak = (1 << d->vi->format->bitsPerSample) - 1;
-
-                            invert_i16m((const uint16_t *)srcp, (uint16_t *)dstp, width, height, stride, peak);
-                        }
-                    }
-                } else if (d->vi->format->sampleType == stFloat) {
-                    if (d->vi->format->bytesPerSample == 4) {
-                        const bool uv = (plane > 0) && ((d->vi->format->colorFamily == cmYUV) || (d->vi->format->colorFamily == cmYCoCg));
-
-                        invert_f32((const float *)srcp, (float *)dstp, width, height, stride, uv);
-                    }
-                }
-            }
-        }
+        struct FrameArgs args;
+        setFramePlanes(&args, src, NULL, dst, d->process, d->vi, vsapi);
+
+        runFrame(&args, d->vi->format, invert_frame_i8, invert_frame_i16, invert_frame_f32);
 
         vsapi->freeFrame(src);
         return dst;
@@ -119,28 +144,14 @@ static const VSFrameRef *VS_CC limiterGetFrame(int n, int activationReason, void
         const VSFrameRef *fr[] = {d->process[0] ? NULL : src, d->process[1] ? NULL : src, d->process[2] ? NULL : src};
         VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src, core);
 
-        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
-            if (d->process[plane]) {
-                int stride = vsapi->getStride(src, plane) / d->vi->format->bytesPerSample;
-                int height = vsapi->getFrameHeight(src, plane);
-                int width = vsapi->getFrameWidth(src, plane);
-                const uint8_t * VS_RESTRICT srcp = vsapi->getReadPtr(src, plane);
-                uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
-
-                if (d->vi->format->sampleType == stInteger) {
-                    if (d->vi->format->bytesPerSample == 1) {
-                        limiter_i8(srcp, dstp, width, height, stride, (uint8_t)d->mini[plane], (uint8_t)d->maxi[plane]);
-
-                    } else if (d->vi->format->bytesPerSample == 2) {
-                        limiter_i16((const uint16_t *)srcp, (uint16_t *)dstp, width, height, stride, d->mini[plane], d->maxi[plane]);
-                    }
-                } else if (d->vi->format->sampleType == stFloat) {
-                    if (d->vi->format->bytesPerSample == 4) {
-                        limiter_f32((const float *)srcp, (float *)dstp, width, height, stride, d->minf[plane], d->maxf[plane]);
-                    }
-                }
-            }
-        }
+        struct FrameArgs args;
+        setFramePlanes(&args, src, NULL, dst, d->process, d->vi, vsapi);
+        memcpy(args.mini, d->mini, sizeof(args.mini));
+        memcpy(args.maxi, d->maxi, sizeof(args.maxi));
+        memcpy(args.minf, d->minf, sizeof(args.minf));
+        memcpy(args.maxf, d->maxf, sizeof(args.maxf));
+
+        runFrame(&args, d->vi->format, limiter_frame_i8, limiter_frame_i16, limiter_frame_f32);
 
         vsapi->freeFrame(src);
         return dst;
@@ -288,28 +299,16 @@ static const VSFrameRef *VS_CC binarizeGetFrame(int n, int activationReason, voi
         const VSFrameRef *fr[] = {d->process[0] ? NULL : src, d->process[1] ? NULL : src, d->process[2] ? NULL : src};
         VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src, core);
 
-        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
-            if (d->process[plane]) {
-                int stride = vsapi->getStride(src, plane) / d->vi->format->bytesPerSample;
-                int height = vsapi->getFrameHeight(src, plane);
-                int width = vsapi->getFrameWidth(src, plane);
-                const uint8_t * VS_RESTRICT srcp = vsapi->getReadPtr(src, plane);
-                uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
-
-                if (d->vi->format->sampleType == stInteger) {
-                    if (d->vi->format->bytesPerSample == 1) {
-                        binarize_i8(srcp, dstp, width, height, stride, (uint8_t)d->thresholdi[plane], (uint8_t)d->v0i[plane], (uint8_t)d->v1i[plane]);
-
-                    } else if (d->vi->format->bytesPerSample == 2) {
-                        binarize_i16((const uint16_t *)srcp, (uint16_t *)dstp, width, height, stride, d->thresholdi[plane], d->v0i[plane], d->v1i[plane]);
-                    }
-                } else if (d->vi->format->sampleType == stFloat) {
-                    if (d->vi->format->bytesPerSample == 4) {
-                        binarize_f32((const float *)srcp, (float *)dstp, width, height, stride, d->thresholdf[plane], d->v0f[plane], d->v1f[plane]);
-                    }
-                }
-            }
-        }
+        struct FrameArgs args;
+        setFramePlanes(&args, src, NULL, dst, d->process, d->vi, vsapi);
+        memcpy(args.thresholdi, d->thresholdi, sizeof(args.thresholdi));
+        memcpy(args.v0i, d->v0i, sizeof(args.v0i));
+        memcpy(args.v1i, d->v1i, sizeof(args.v1i));
+        memcpy(args.thresholdf, d->thresholdf, sizeof(args.thresholdf));
+        memcpy(args.v0f, d->v0f, sizeof(args.v0f));
+        memcpy(args.v1f, d->v1f, sizeof(args.v1f));
+
+        runFrame(&args, d->vi->format, binarize_frame_i8, binarize_frame_i16, binarize_frame_f32);
 
         vsapi->freeFrame(src);
         return dst;
@@ -475,34 +474,28 @@ static const VSFrameRef *VS_CC mergeGetFrame(int n, int activationReason, void *
         const VSFrameRef *src1 = vsapi->getFrameFilter(n, d->node1, frameCtx);
         const VSFrameRef *src2 = vsapi->getFrameFilter(n, d->node2, frameCtx);
 
+        VSFrameRef *cached = frameCacheTryGet(d->cache, src1, src2, core, vsapi);
+        if (cached) {
+            vsapi->freeFrame(src1);
+            vsapi->freeFrame(src2);
+            return cached;
+        }
+
         const int pl[] = { 0, 1, 2 };
         const VSFrameRef *fs[] = { NULL, src1, src2 }; // kMerge, kCopyFirst, kCopySecond
         const VSFrameRef *fr[] = {fs[d->process[0]], fs[d->process[1]], fs[d->process[2]]};
         VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src1, core);
 
-        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
-            if (d->process[plane] == kMerge) {
-                int stride = vsapi->getStride(src1, plane) / d->vi->format->bytesPerSample;
-                int height = vsapi->getFrameHeight(src1, plane);
-                int width = vsapi->getFrameWidth(src1, plane);
-                const uint8_t * VS_RESTRICT srcp1 = vsapi->getReadPtr(src1, plane);
-                const uint8_t * VS_RESTRICT srcp2 = vsapi->getReadPtr(src2, plane);
-                uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
-
-                if (d->vi->format->sampleType == stInteger) {
-                    if (d->vi->format->bytesPerSample == 1) {
-                        merge_i8(srcp1, srcp2, dstp, width, height, stride, d->weighti[plane]);
-
-                    } else if (d->vi->format->bytesPerSample == 2) {
-                        merge_i16((const uint16_t *)srcp1, (const uint16_t *)srcp2, (uint16_t *)dstp, width, height, stride, d->weighti[plane]);
-                    }
-                } else if (d->vi->format->sampleType == stFloat) {
-                    if (d->vi->format->bytesPerSample == 4) {
-                        merge_f32((const float *)srcp1, (const float *)srcp2, (float *)dstp, width, height, stride, d->weightf[plane]);
-                    }
-                }
-            }
-        }
+        const bool merge[] = { d->process[0] == kMerge, d->process[1] == kMerge, d->process[2] == kMerge };
+
+        struct FrameArgs args;
+        setFramePlanes(&args, src1, src2, dst, merge, d->vi, vsapi);
+        memcpy(args.weighti, d->weighti, sizeof(args.weighti));
+        memcpy(args.weightf, d->weightf, sizeof(args.weightf));
+
+        runFrame(&args, d->vi->format, merge_frame_i8, merge_frame_i16, merge_frame_f32);
+
+        frameCacheInsert(d->cache, src1, src2, dst, vsapi);
 
         vsapi->freeFrame(src1);
         vsapi->freeFrame(src2);
@@ -516,6 +509,7 @@ static void VS_CC mergeFree(void *instanceData, VSCore *core, const VSAPI *vsapi
     MergeData *d = (MergeData *)instanceData;
     vsapi->freeNode(d->node1);
     vsapi->freeNode(d->node2);
+    frameCacheFree(d->cache, vsapi);
     free(d);
 }
 
@@ -596,16 +590,114 @@ void VS_CC mergeCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core
         }
     }
 
+    if (!frameCacheParseArg(in, out, "Merge", &d.cache, vsapi)) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        return;
+    }
+
     MergeData * const data = malloc(sizeof(d));
     *data = d;
 
     vsapi->createFilter(in, out, "Merge", mergeInit, mergeGetFrame, mergeFree, fmParallel, 0, data, core);
 }
 
+// MakeDiff, MergeDiff across formats
+typedef void (*DiffConvertFunc)(const uint8_t *srcp1, const uint8_t *srcp2, uint8_t *dstp, int32_t width, int32_t height, 
+                                int32_t stride1, int32_t stride2, int32_t dst_stride, float scale1, float scale2, float offset, float peak);
+
+// indexed by the sample types of clipa, clipb and the output, see sampleTypeIndex()
+static const DiffConvertFunc diffConvertFuncs[3][3][3] = {
+    { { diff_convert_i8_i8_i8, diff_convert_i8_i8_i16, diff_convert_i8_i8_f32 },
+      { diff_convert_i8_i16_i8, diff_convert_i8_i16_i16, diff_convert_i8_i16_f32 },
+      { diff_convert_i8_f32_i8, diff_convert_i8_f32_i16, diff_convert_i8_f32_f32 } },
+    { { diff_convert_i16_i8_i8, diff_convert_i16_i8_i16, diff_convert_i16_i8_f32 },
+      { diff_convert_i16_i16_i8, diff_convert_i16_i16_i16, diff_convert_i16_i16_f32 },
+      { diff_convert_i16_f32_i8, diff_convert_i16_f32_i16, diff_convert_i16_f32_f32 } },
+    { { diff_convert_f32_i8_i8, diff_convert_f32_i8_i16, diff_convert_f32_i8_f32 },
+      { diff_convert_f32_i16_i8, diff_convert_f32_i16_i16, diff_convert_f32_i16_f32 },
+      { diff_convert_f32_f32_i8, diff_convert_f32_f32_i16, diff_convert_f32_f32_f32 } }
+};
+
+static int sampleTypeIndex(const VSFormat *f) {
+    return (f->sampleType == stFloat) ? 2 : f->bytesPerSample - 1;
+}
+
+static bool isSupportedDiffFormat(const VSFormat *f) {
+    return (f->sampleType == stInteger && (f->bytesPerSample == 1 || f->bytesPerSample == 2))
+        || (f->sampleType == stFloat && f->bytesPerSample == 4);
+}
+
+// raw sample of fi -> raw sample of fo as raw * scale + offset.
+// Integer depths are converted by bit shifts, integer and float by full range,
+// and centred samples (differences and chroma) keep their centre. _ColorRange is not read.
+static void depthMapping(const VSFormat *fi, const VSFormat *fo, bool centred, double *scale, double *offset) {
+    if (fi->sampleType == stInteger && fo->sampleType == stInteger) {
+        *scale = ldexp(1.0, fo->bitsPerSample - fi->bitsPerSample);
+        *offset = 0.0;
+    } else if (fi->sampleType == stInteger) {
+        *scale = 1.0 / ((1 << fi->bitsPerSample) - 1);
+        *offset = centred ? -(1 << (fi->bitsPerSample - 1)) * *scale : 0.0;
+    } else if (fo->sampleType == stInteger) {
+        *scale = (1 << fo->bitsPerSample) - 1;
+        *offset = centred ? (1 << (fo->bitsPerSample - 1)) : 0.0;
+    } else {
+        *scale = 1.0;
+        *offset = 0.0;
+    }
+}
+
+// Per-plane coefficients of diff_convert_*. clipb holds differences for MergeDiff.
+// Planes that are not processed are clipa converted to the output format.
+static void diffConversion(const VSFormat *fa, const VSFormat *fb, const VSFormat *fo, const bool process[3], bool merge, 
+                           float scale1[3], float scale2[3], float offset[3]) {
+    const double centre = (fo->sampleType == stInteger) ? (1 << (fo->bitsPerSample - 1)) : 0.0;
+
+    for (int plane = 0; plane < 3; plane++) {
+        const bool chroma = (plane > 0) && ((fo->colorFamily == cmYUV) || (fo->colorFamily == cmYCoCg));
+        double sa, oa, sb, ob;
+
+        depthMapping(fa, fo, chroma, &sa, &oa);
+        depthMapping(fb, fo, merge || chroma, &sb, &ob);
+
+        scale1[plane] = (float)sa;
+
+        if (!process[plane]) {
+            scale2[plane] = 0.f;
+            offset[plane] = (float)oa;
+        } else if (merge) {
+            scale2[plane] = (float)sb;
+            offset[plane] = (float)(oa + ob - centre);
+        } else {
+            scale2[plane] = (float)-sb;
+            offset[plane] = (float)(oa - ob + centre);
+        }
+    }
+}
+
+static void diffConvertFrame(const VSFrameRef *src1, const VSFrameRef *src2, VSFrameRef *dst, const bool process[3], 
+                             const float scale1[3], const float scale2[3], const float offset[3], const VSAPI *vsapi) {
+    const VSFormat *fa = vsapi->getFrameFormat(src1);
+    const VSFormat *fb = vsapi->getFrameFormat(src2);
+    const VSFormat *fo = vsapi->getFrameFormat(dst);
+    const DiffConvertFunc func = diffConvertFuncs[sampleTypeIndex(fa)][sampleTypeIndex(fb)][sampleTypeIndex(fo)];
+    const float peak = (fo->sampleType == stInteger) ? (float)((1 << fo->bitsPerSample) - 1) : 1.f;
+
+    for (int plane = 0; plane < fo->numPlanes; plane++) {
+        if (!process[plane])
+            continue;
+
+        func(vsapi->getReadPtr(src1, plane), vsapi->getReadPtr(src2, plane), vsapi->getWritePtr(dst, plane), 
+             vsapi->getFrameWidth(dst, plane), vsapi->getFrameHeight(dst, plane), 
+             vsapi->getStride(src1, plane) / fa->bytesPerSample, vsapi->getStride(src2, plane) / fb->bytesPerSample, 
+             vsapi->getStride(dst, plane) / fo->bytesPerSample, scale1[plane], scale2[plane], offset[plane], peak);
+    }
+}
+
 // MakeDiff
 static void VS_CC makeDiffInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
     MakeDiffData *d = (MakeDiffData *) * instanceData;
-    vsapi->setVideoInfo(d->vi, 1, node);
+    vsapi->setVideoInfo(&d->out_vi, 1, node);
 }
 
 static const VSFrameRef *VS_CC makeDiffGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
@@ -618,37 +710,34 @@ static const VSFrameRef *VS_CC makeDiffGetFrame(int n, int activationReason, voi
         const VSFrameRef *src1 = vsapi->getFrameFilter(n, d->node1, frameCtx);
         const VSFrameRef *src2 = vsapi->getFrameFilter(n, d->node2, frameCtx);
 
-        const int pl[] = { 0, 1, 2 };
-        const VSFrameRef *fr[] = { d->process[0] ? NULL : src1, d->process[1] ? NULL : src1, d->process[2] ? NULL : src1 };
-        VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src1, core);
+        VSFrameRef *cached = frameCacheTryGet(d->cache, src1, src2, core, vsapi);
+        if (cached) {
+            vsapi->freeFrame(src1);
+            vsapi->freeFrame(src2);
+            return cached;
+        }
 
-        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
-            if (d->process[plane]) {
-                int stride = vsapi->getStride(src1, plane) / d->vi->format->bytesPerSample;
-                int height = vsapi->getFrameHeight(src1, plane);
-                int width = vsapi->getFrameWidth(src1, plane);
-                const uint8_t * VS_RESTRICT srcp1 = vsapi->getReadPtr(src1, plane);
-                const uint8_t * VS_RESTRICT srcp2 = vsapi->getReadPtr(src2, plane);
-                uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
-
-                if (d->vi->format->sampleType == stInteger) {
-                    if (d->vi->format->bytesPerSample == 1) {
-                        make_diff_i8(srcp1, srcp2, dstp, width, height, stride);
-
-                    } else if (d->vi->format->bytesPerSample == 2) {
-                        const int halfpoint = 1 << (d->vi->format->bitsPerSample - 1);
-                        const int maxvalue = (1 << d->vi->format->bitsPerSample) - 1;
-
-                        make_diff_i16((const uint16_t *)srcp1, (const uint16_t *)srcp2, (uint16_t *)dstp, width, height, stride, halfpoint, maxvalue);
-                    }
-                } else if (d->vi->format->sampleType == stFloat) {
-                    if (d->vi->format->bytesPerSample == 4) {
-                        make_diff_f32((const float *)srcp1, (const float *)srcp2, (float *)dstp, width, height, stride);
-                    }
-                }
-            }
+        VSFrameRef *dst;
+
+        if (d->convert) {
+            const int pl[] = { 0, 1, 2 };
+            const VSFrameRef *fr[] = { d->convert_planes[0] ? NULL : src1, d->convert_planes[1] ? NULL : src1, d->convert_planes[2] ? NULL : src1 };
+            dst = vsapi->newVideoFrame2(d->out_vi.format, d->out_vi.width, d->out_vi.height, fr, pl, src1, core);
+
+            diffConvertFrame(src1, src2, dst, d->convert_planes, d->scale1, d->scale2, d->offset, vsapi);
+        } else {
+            const int pl[] = { 0, 1, 2 };
+            const VSFrameRef *fr[] = { d->process[0] ? NULL : src1, d->process[1] ? NULL : src1, d->process[2] ? NULL : src1 };
+            dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src1, core);
+
+            struct FrameArgs args;
+            setFramePlanes(&args, src1, src2, dst, d->process, d->vi, vsapi);
+
+            runFrame(&args, d->vi->format, make_diff_frame_i8, make_diff_frame_i16, make_diff_frame_f32);
         }
 
+        frameCacheInsert(d->cache, src1, src2, dst, vsapi);
+
         vsapi->freeFrame(src1);
         vsapi->freeFrame(src2);
         return dst;
@@ -661,6 +750,7 @@ static void VS_CC makeDiffFree(void *instanceData, VSCore *core, const VSAPI *vs
     MakeDiffData *d = (MakeDiffData *)instanceData;
     vsapi->freeNode(d->node1);
     vsapi->freeNode(d->node2);
+    frameCacheFree(d->cache, vsapi);
     free(d);
 }
 
@@ -671,22 +761,32 @@ void VS_CC makeDiffCreate(const VSMap *in, VSMap *out, void *userData, VSCore *c
     d.node2 = vsapi->propGetNode(in, "clipb", 0, NULL);
     d.vi = vsapi->getVideoInfo(d.node1);
 
-    if (!isConstantFormat(d.vi) || !isSameFormat(d.vi, vsapi->getVideoInfo(d.node2))) {
+    const VSVideoInfo *vi2 = vsapi->getVideoInfo(d.node2);
+
+    if (!isConstantFormat(d.vi) || !isConstantFormat(vi2) || d.vi->width != vi2->width || d.vi->height != vi2->height) {
         vsapi->freeNode(d.node1);
         vsapi->freeNode(d.node2);
-        vsapi->setError(out, "ispc.MakeDiff: both clips must have constant format and dimensions, and the same format and dimensions");
+        vsapi->setError(out, "ispc.MakeDiff: both clips must have constant format and dimensions, and the same dimensions");
         return;
     }
 
-    if ((d.vi->format->colorFamily == cmCompat) || (vsapi->getVideoInfo(d.node2)->format->colorFamily == cmCompat)) {
+    if ((d.vi->format->colorFamily == cmCompat) || (vi2->format->colorFamily == cmCompat)) {
         vsapi->freeNode(d.node1);
         vsapi->freeNode(d.node2);
         vsapi->setError(out, "ispc.MakeDiff: compat formats are not supported");
         return;
     }
 
-    if ((d.vi->format->sampleType == stInteger && d.vi->format->bytesPerSample != 1 && d.vi->format->bytesPerSample != 2)
-        || (d.vi->format->sampleType == stFloat && d.vi->format->bytesPerSample != 4)) {
+    // bit depth and sample type may differ
+    if (d.vi->format->colorFamily != vi2->format->colorFamily 
+        || d.vi->format->subSamplingW != vi2->format->subSamplingW || d.vi->format->subSamplingH != vi2->format->subSamplingH) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        vsapi->setError(out, "ispc.MakeDiff: both clips must have the same color family and subsampling");
+        return;
+    }
+
+    if (!isSupportedDiffFormat(d.vi->format) || !isSupportedDiffFormat(vi2->format)) {
         vsapi->freeNode(d.node1);
         vsapi->freeNode(d.node2);
         vsapi->setError(out, "ispc.MakeDiff: only 8-16 bit integer and 32 bit float input supported");
@@ -719,6 +819,41 @@ void VS_CC makeDiffCreate(const VSMap *in, VSMap *out, void *userData, VSCore *c
         d.process[plane] = true;
     }
 
+    int err;
+
+    const VSFormat *fo = d.vi->format;
+
+    int format_id = int64ToIntS(vsapi->propGetInt(in, "format", 0, &err));
+    if (!err) {
+        fo = vsapi->getFormatPreset(format_id, core);
+
+        if (fo == NULL || fo->colorFamily != d.vi->format->colorFamily 
+            || fo->subSamplingW != d.vi->format->subSamplingW || fo->subSamplingH != d.vi->format->subSamplingH 
+            || !isSupportedDiffFormat(fo)) {
+            vsapi->freeNode(d.node1);
+            vsapi->freeNode(d.node2);
+            vsapi->setError(out, "ispc.MakeDiff: \"format\" must have the color family and subsampling of the clips, and 8-16 bit integer or 32 bit float samples");
+            return;
+        }
+    }
+
+    d.out_vi = *d.vi;
+    d.out_vi.format = fo;
+    d.convert = (vi2->format != d.vi->format) || (fo != d.vi->format);
+
+    // unprocessed planes only need converting when the output format differs from clipa
+    for (int i = 0; i < 3; i++)
+        d.convert_planes[i] = d.process[i] || (fo != d.vi->format);
+
+    if (d.convert)
+        diffConversion(d.vi->format, vi2->format, fo, d.process, false, d.scale1, d.scale2, d.offset);
+
+    if (!frameCacheParseArg(in, out, "MakeDiff", &d.cache, vsapi)) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        return;
+    }
+
     MakeDiffData * const data = malloc(sizeof(d));
     *data = d;
 
@@ -728,7 +863,7 @@ void VS_CC makeDiffCreate(const VSMap *in, VSMap *out, void *userData, VSCore *c
 // MergeDiff
 static void VS_CC mergeDiffInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
     MergeDiffData *d = (MergeDiffData *) * instanceData;
-    vsapi->setVideoInfo(d->vi, 1, node);
+    vsapi->setVideoInfo(&d->out_vi, 1, node);
 }
 
 static const VSFrameRef *VS_CC mergeDiffGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
@@ -741,37 +876,34 @@ static const VSFrameRef *VS_CC mergeDiffGetFrame(int n, int activationReason, vo
         const VSFrameRef *src1 = vsapi->getFrameFilter(n, d->node1, frameCtx);
         const VSFrameRef *src2 = vsapi->getFrameFilter(n, d->node2, frameCtx);
 
-        const int pl[] = { 0, 1, 2 };
-        const VSFrameRef *fr[] = { d->process[0] ? NULL : src1, d->process[1] ? NULL : src1, d->process[2] ? NULL : src1 };
-        VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src1, core);
+        VSFrameRef *cached = frameCacheTryGet(d->cache, src1, src2, core, vsapi);
+        if (cached) {
+            vsapi->freeFrame(src1);
+            vsapi->freeFrame(src2);
+            return cached;
+        }
 
-        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
-            if (d->process[plane]) {
-                int stride = vsapi->getStride(src1, plane) / d->vi->format->bytesPerSample;
-                int height = vsapi->getFrameHeight(src1, plane);
-                int width = vsapi->getFrameWidth(src1, plane);
-                const uint8_t * VS_RESTRICT srcp1 = vsapi->getReadPtr(src1, plane);
-                const uint8_t * VS_RESTRICT srcp2 = vsapi->getReadPtr(src2, plane);
-                uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
-
-                if (d->vi->format->sampleType == stInteger) {
-                    if (d->vi->format->bytesPerSample == 1) {
-                        merge_diff_i8(srcp1, srcp2, dstp, width, height, stride);
-
-                    } else if (d->vi->format->bytesPerSample == 2) {
-                        const int halfpoint = 1 << (d->vi->format->bitsPerSample - 1);
-                        const int maxvalue = (1 << d->vi->format->bitsPerSample) - 1;
-
-                        merge_diff_i16((const uint16_t *)srcp1, (const uint16_t *)srcp2, (uint16_t *)dstp, width, height, stride, halfpoint, maxvalue);
-                    }
-                } else if (d->vi->format->sampleType == stFloat) {
-                    if (d->vi->format->bytesPerSample == 4) {
-                        merge_diff_f32((const float *)srcp1, (const float *)srcp2, (float *)dstp, width, height, stride);
-                    }
-                }
-            }
+        VSFrameRef *dst;
+
+        if (d->convert) {
+            const int pl[] = { 0, 1, 2 };
+            const VSFrameRef *fr[] = { d->convert_planes[0] ? NULL : src1, d->convert_planes[1] ? NULL : src1, d->convert_planes[2] ? NULL : src1 };
+            dst = vsapi->newVideoFrame2(d->out_vi.format, d->out_vi.width, d->out_vi.height, fr, pl, src1, core);
+
+            diffConvertFrame(src1, src2, dst, d->convert_planes, d->scale1, d->scale2, d->offset, vsapi);
+        } else {
+            const int pl[] = { 0, 1, 2 };
+            const VSFrameRef *fr[] = { d->process[0] ? NULL : src1, d->process[1] ? NULL : src1, d->process[2] ? NULL : src1 };
+            dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src1, core);
+
+            struct FrameArgs args;
+            setFramePlanes(&args, src1, src2, dst, d->process, d->vi, vsapi);
+
+            runFrame(&args, d->vi->format, merge_diff_frame_i8, merge_diff_frame_i16, merge_diff_frame_f32);
         }
 
+        frameCacheInsert(d->cache, src1, src2, dst, vsapi);
+
         vsapi->freeFrame(src1);
         vsapi->freeFrame(src2);
         return dst;
@@ -784,6 +916,7 @@ static void VS_CC mergeDiffFree(void *instanceData, VSCore *core, const VSAPI *v
     MergeDiffData *d = (MergeDiffData *)instanceData;
     vsapi->freeNode(d->node1);
     vsapi->freeNode(d->node2);
+    frameCacheFree(d->cache, vsapi);
     free(d);
 }
 
@@ -794,22 +927,32 @@ void VS_CC mergeDiffCreate(const VSMap *in, VSMap *out, void *userData, VSCore *
     d.node2 = vsapi->propGetNode(in, "clipb", 0, NULL);
     d.vi = vsapi->getVideoInfo(d.node1);
 
-    if (!isConstantFormat(d.vi) || !isSameFormat(d.vi, vsapi->getVideoInfo(d.node2))) {
+    const VSVideoInfo *vi2 = vsapi->getVideoInfo(d.node2);
+
+    if (!isConstantFormat(d.vi) || !isConstantFormat(vi2) || d.vi->width != vi2->width || d.vi->height != vi2->height) {
         vsapi->freeNode(d.node1);
         vsapi->freeNode(d.node2);
-        vsapi->setError(out, "ispc.MergeDiff: both clips must have constant format and dimensions, and the same format and dimensions");
+        vsapi->setError(out, "ispc.MergeDiff: both clips must have constant format and dimensions, and the same dimensions");
         return;
     }
 
-    if ((d.vi->format->colorFamily == cmCompat) || (vsapi->getVideoInfo(d.node2)->format->colorFamily == cmCompat)) {
+    if ((d.vi->format->colorFamily == cmCompat) || (vi2->format->colorFamily == cmCompat)) {
         vsapi->freeNode(d.node1);
         vsapi->freeNode(d.node2);
         vsapi->setError(out, "ispc.MergeDiff: compat formats are not supported");
         return;
     }
 
-    if ((d.vi->format->sampleType == stInteger && d.vi->format->bytesPerSample != 1 && d.vi->format->bytesPerSample != 2)
-        || (d.vi->format->sampleType == stFloat && d.vi->format->bytesPerSample != 4)) {
+    // bit depth and sample type may differ
+    if (d.vi->format->colorFamily != vi2->format->colorFamily 
+        || d.vi->format->subSamplingW != vi2->format->subSamplingW || d.vi->format->subSamplingH != vi2->format->subSamplingH) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        vsapi->setError(out, "ispc.MergeDiff: both clips must have the same color family and subsampling");
+        return;
+    }
+
+    if (!isSupportedDiffFormat(d.vi->format) || !isSupportedDiffFormat(vi2->format)) {
         vsapi->freeNode(d.node1);
         vsapi->freeNode(d.node2);
         vsapi->setError(out, "ispc.MergeDiff: only 8-16 bit integer and 32 bit float input supported");
@@ -842,8 +985,228 @@ void VS_CC mergeDiffCreate(const VSMap *in, VSMap *out, void *userData, VSCore *
         d.process[plane] = true;
     }
 
+    int err;
+
+    const VSFormat *fo = d.vi->format;
+
+    int format_id = int64ToIntS(vsapi->propGetInt(in, "format", 0, &err));
+    if (!err) {
+        fo = vsapi->getFormatPreset(format_id, core);
+
+        if (fo == NULL || fo->colorFamily != d.vi->format->colorFamily 
+            || fo->subSamplingW != d.vi->format->subSamplingW || fo->subSamplingH != d.vi->format->subSamplingH 
+            || !isSupportedDiffFormat(fo)) {
+            vsapi->freeNode(d.node1);
+            vsapi->freeNode(d.node2);
+            vsapi->setError(out, "ispc.MergeDiff: \"format\" must have the color family and subsampling of the clips, and 8-16 bit integer or 32 bit float samples");
+            return;
+        }
+    }
+
+    d.out_vi = *d.vi;
+    d.out_vi.format = fo;
+    d.convert = (vi2->format != d.vi->format) || (fo != d.vi->format);
+
+    // unprocessed planes only need converting when the output format differs from clipa
+    for (int i = 0; i < 3; i++)
+        d.convert_planes[i] = d.process[i] || (fo != d.vi->format);
+
+    if (d.convert)
+        diffConversion(d.vi->format, vi2->format, fo, d.process, true, d.scale1, d.scale2, d.offset);
+
+    if (!frameCacheParseArg(in, out, "MergeDiff", &d.cache, vsapi)) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        return;
+    }
+
     MergeDiffData * const data = malloc(sizeof(d));
     *data = d;
 
     vsapi->createFilter(in, out, "MergeDiff", mergeDiffInit, mergeDiffGetFrame, mergeDiffFree, fmParallel, 0, data, core);
 }
+
+// Levels
+static void VS_CC levelsInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    LevelsData *d = (LevelsData *) * instanceData;
+    vsapi->setVideoInfo(d->vi, 1, node);
+}
+
+static const VSFrameRef *VS_CC levelsGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    LevelsData *d = (LevelsData *) * instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+
+        const int pl[] = { 0, 1, 2 };
+        const VSFrameRef *fr[] = {d->process[0] ? NULL : src, d->process[1] ? NULL : src, d->process[2] ? NULL : src};
+        VSFrameRef *dst = vsapi->newVideoFrame2(d->vi->format, d->vi->width, d->vi->height, fr, pl, src, core);
+
+        struct FrameArgs args;
+        setFramePlanes(&args, src, NULL, dst, d->process, d->vi, vsapi);
+        for (int plane = 0; plane < 3; plane++) {
+            args.lut[plane] = (const uint8_t *)d->lut[plane];
+        }
+        memcpy(args.min_in, d->min_in, sizeof(args.min_in));
+        memcpy(args.max_in, d->max_in, sizeof(args.max_in));
+        memcpy(args.gamma, d->gamma, sizeof(args.gamma));
+        memcpy(args.min_out, d->min_out, sizeof(args.min_out));
+        memcpy(args.max_out, d->max_out, sizeof(args.max_out));
+
+        runFrame(&args, d->vi->format, levels_frame_i8, levels_frame_i16, levels_frame_f32);
+
+        vsapi->freeFrame(src);
+        return dst;
+    }
+
+    return 0;
+}
+
+static void VS_CC levelsFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    LevelsData *d = (LevelsData *)instanceData;
+    vsapi->freeNode(d->node);
+    for (int i = 0; i < 3; i++)
+        free(d->lut[i]);
+    free(d);
+}
+
+// missing values repeat the last specified one
+static void levelsGetParam(const VSMap *in, const VSAPI *vsapi, const char *name, float defaultValue, float values[3]) {
+    bool prevValid = false;
+    for (int i = 0; i < 3; i++) {
+        int err;
+
+        float temp = (float)vsapi->propGetFloat(in, name, i, &err);
+        if (err) {
+            temp = prevValid ? values[i-1] : defaultValue;
+        } else {
+            prevValid = true;
+        }
+
+        values[i] = temp;
+    }
+}
+
+void VS_CC levelsCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    LevelsData d;
+
+    d.node = vsapi->propGetNode(in, "clip", 0, NULL);
+    d.vi = vsapi->getVideoInfo(d.node);
+
+    if (!isConstantFormat(d.vi) || d.vi->format->colorFamily == cmCompat) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Levels: only constant format input supported, and compat formats are not supported");
+        return;
+    }
+
+    if ((d.vi->format->sampleType == stInteger && d.vi->format->bytesPerSample != 1 && d.vi->format->bytesPerSample != 2)
+        || (d.vi->format->sampleType == stFloat && d.vi->format->bytesPerSample != 4)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Levels: only 8-16 bit integer and 32 bit float input supported");
+        return;
+    }
+
+    int num_planes = d.vi->format->numPlanes;
+
+    static const char * const params[] = { "min_in", "max_in", "gamma", "min_out", "max_out" };
+    for (int i = 0; i < 5; i++) {
+        if (vsapi->propNumElements(in, params[i]) > num_planes) {
+            vsapi->freeNode(d.node);
+            char msg[80];
+            snprintf(msg, sizeof(msg), "ispc.Levels: \"%s\" has more values specified than there are planes", params[i]);
+            vsapi->setError(out, msg);
+            return;
+        }
+    }
+
+    const float peak = (d.vi->format->sampleType == stInteger) ? (float)((1 << d.vi->format->bitsPerSample) - 1) : 1.f;
+
+    levelsGetParam(in, vsapi, "min_in", 0.f, d.min_in);
+    levelsGetParam(in, vsapi, "max_in", peak, d.max_in);
+    levelsGetParam(in, vsapi, "gamma", 1.f, d.gamma);
+    levelsGetParam(in, vsapi, "min_out", 0.f, d.min_out);
+    levelsGetParam(in, vsapi, "max_out", peak, d.max_out);
+
+    for (int i = 0; i < num_planes; i++) {
+        if (d.gamma[i] <= 0.f) {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Levels: \"gamma\" must be greater than 0");
+            return;
+        }
+
+        if (d.min_in[i] >= d.max_in[i]) {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Levels: \"min_in\" must be less than \"max_in\"");
+            return;
+        }
+    }
+
+    const int m = vsapi->propNumElements(in, "planes");
+
+    for (int i = 0; i < 3; i++)
+        d.process[i] = (m <= 0);
+
+    for (int i = 0; i < vsapi->propNumElements(in, "planes"); i++) {
+        int plane = int64ToIntS(vsapi->propGetInt(in, "planes", i, NULL));
+
+        if (plane < 0 || plane >= num_planes) {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Levels: plane index out of range");
+            return;
+        }
+
+        if (d.process[plane]) {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Levels: plane specified twice");
+            return;
+        }
+
+        d.process[plane] = true;
+    }
+
+    for (int i = 0; i < 3; i++)
+        d.lut[i] = NULL;
+
+    if (d.vi->format->sampleType == stInteger) {
+        // covers every representable sample value, so out-of-range input never reads past the table
+        const int lut_size = 1 << (8 * d.vi->format->bytesPerSample);
+        const int maxvalue = (1 << d.vi->format->bitsPerSample) - 1;
+
+        for (int plane = 0; plane < num_planes; plane++) {
+            if (!d.process[plane])
+                continue;
+
+            d.lut[plane] = malloc(lut_size * d.vi->format->bytesPerSample);
+            if (!d.lut[plane]) {
+                for (int i = 0; i < 3; i++)
+                    free(d.lut[i]);
+                vsapi->freeNode(d.node);
+                vsapi->setError(out, "ispc.Levels: failed to allocate lookup table");
+                return;
+            }
+
+            const double range_in = (double)d.max_in[plane] - d.min_in[plane];
+            const double range_out = (double)d.max_out[plane] - d.min_out[plane];
+            const double exponent = 1.0 / d.gamma[plane];
+
+            for (int v = 0; v < lut_size; v++) {
+                const double x = VSMAX(VSMIN((double)v, (double)d.max_in[plane]) - d.min_in[plane], 0.0) / range_in;
+                const double y = pow(x, exponent) * range_out + d.min_out[plane] + 0.5;
+                const int value = (int)VSMAX(VSMIN(y, (double)maxvalue), 0.0);
+
+                if (d.vi->format->bytesPerSample == 1) {
+                    ((uint8_t *)d.lut[plane])[v] = (uint8_t)value;
+                } else {
+                    ((uint16_t *)d.lut[plane])[v] = (uint16_t)value;
+                }
+            }
+        }
+    }
+
+    LevelsData * const data = malloc(sizeof(d));
+    *data = d;
+
+    vsapi->createFilter(in, out, "Levels", levelsInit, levelsGetFrame, levelsFree, fmParallel, 0, data, core);
+}
@@ -8,6 +8,8 @@
 #include "VapourSynth.h"
 #include "VSHelper.h"
 
+#include "frame_cache.h"
+
 typedef struct {
     VSNodeRef *node;
     const VSVideoInfo *vi;
@@ -43,6 +45,7 @@ typedef struct {
     enum MergeBehavior {kMerge=0, kCopyFirst=1, kCopySecond=2} process[3];
     int32_t weighti[3];
     float weightf[3];
+    FrameCache *cache; // NULL unless enabled
 } MergeData;
 
 extern void VS_CC mergeCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
@@ -51,7 +54,12 @@ typedef struct {
     VSNodeRef *node1;
     VSNodeRef *node2;
     const VSVideoInfo *vi;
+    VSVideoInfo out_vi;
     bool process[3];
+    bool convert; // clips or output of differing formats
+    bool convert_planes[3]; // planes written by diff_convert_*, the others are shared with clipa
+    float scale1[3], scale2[3], offset[3]; // convert only
+    FrameCache *cache; // NULL unless enabled
 } MakeDiffData;
 
 extern void VS_CC makeDiffCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
@@ -60,9 +68,24 @@ typedef struct {
     VSNodeRef *node1;
     VSNodeRef *node2;
     const VSVideoInfo *vi;
+    VSVideoInfo out_vi;
     bool process[3];
+    bool convert; // clips or output of differing formats
+    bool convert_planes[3]; // planes written by diff_convert_*, the others are shared with clipa
+    float scale1[3], scale2[3], offset[3]; // convert only
+    FrameCache *cache; // NULL unless enabled
 } MergeDiffData;
 
 extern void VS_CC mergeDiffCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
 
+typedef struct {
+    VSNodeRef *node;
+    const VSVideoInfo *vi;
+    bool process[3];
+    void *lut[3];
+    float min_in[3], max_in[3], gamma[3], min_out[3], max_out[3];
+} LevelsData;
+
+extern void VS_CC levelsCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
+
 #endif // ISPC_ELEMENT_WISE_H
@@ -0,0 +1,228 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "frame_cache.h"
+
+static void frameCacheAcquire(FrameCache *cache) {
+    while (atomic_flag_test_and_set_explicit(&cache->lock, memory_order_acquire))
+        ;
+}
+
+static void frameCacheRelease(FrameCache *cache) {
+    atomic_flag_clear_explicit(&cache->lock, memory_order_release);
+}
+
+// read pointers of every plane, NULL for planes the format doesn't have
+static void frameCacheKey(const VSFrameRef *frame, const uint8_t *planes[3], const VSAPI *vsapi) {
+    const int num_planes = vsapi->getFrameFormat(frame)->numPlanes;
+
+    for (int plane = 0; plane < 3; plane++)
+        planes[plane] = (plane < num_planes) ? vsapi->getReadPtr(frame, plane) : NULL;
+}
+
+// called with the lock held
+static int frameCacheFind(const FrameCache *cache, const uint8_t *planes[2][3]) {
+    for (int i = 0; i < cache->capacity; i++) {
+        const FrameCacheEntry *entry = &cache->entries[i];
+
+        if (entry->frame && !memcmp(entry->planes, planes, sizeof(entry->planes)))
+            return i;
+    }
+
+    return -1;
+}
+
+// visible samples of every plane, stopping at the first differing row
+static bool frameCacheEqual(const VSFrameRef *a, const VSFrameRef *b, const VSAPI *vsapi) {
+    const VSFormat *fi = vsapi->getFrameFormat(a);
+
+    if (fi != vsapi->getFrameFormat(b) || vsapi->getFrameWidth(a, 0) != vsapi->getFrameWidth(b, 0) 
+        || vsapi->getFrameHeight(a, 0) != vsapi->getFrameHeight(b, 0))
+        return false;
+
+    for (int plane = 0; plane < fi->numPlanes; plane++) {
+        const size_t row_bytes = (size_t)vsapi->getFrameWidth(a, plane) * fi->bytesPerSample;
+        const int height = vsapi->getFrameHeight(a, plane);
+        const int stride_a = vsapi->getStride(a, plane);
+        const int stride_b = vsapi->getStride(b, plane);
+        const uint8_t *pa = vsapi->getReadPtr(a, plane);
+        const uint8_t *pb = vsapi->getReadPtr(b, plane);
+
+        if (pa == pb)
+            continue;
+
+        for (int i = 0; i < height; i++) {
+            if (memcmp(pa + (size_t)i * stride_a, pb + (size_t)i * stride_b, row_bytes))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// Writes the current counters as the ISPCCacheHits and ISPCCacheMisses frame properties
+static void frameCacheSetProps(FrameCache *cache, VSFrameRef *frame, const VSAPI *vsapi) {
+    frameCacheAcquire(cache);
+    const int64_t hits = cache->hits;
+    const int64_t misses = cache->misses;
+    frameCacheRelease(cache);
+
+    VSMap *props = vsapi->getFramePropsRW(frame);
+    vsapi->propSetInt(props, "ISPCCacheHits", hits, paReplace);
+    vsapi->propSetInt(props, "ISPCCacheMisses", misses, paReplace);
+}
+
+FrameCache *frameCacheCreate(int capacity) {
+    FrameCache *cache = malloc(sizeof(FrameCache));
+    if (!cache)
+        return NULL;
+
+    *cache = (FrameCache){ .entries = calloc(capacity, sizeof(FrameCacheEntry)), .capacity = capacity, .next = 0,
+                           .recent = -1, .lock = ATOMIC_FLAG_INIT, .hits = 0, .misses = 0 };
+
+    if (!cache->entries) {
+        free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+void frameCacheFree(FrameCache *cache, const VSAPI *vsapi) {
+    if (!cache)
+        return;
+
+    for (int i = 0; i < cache->capacity; i++) {
+        vsapi->freeFrame(cache->entries[i].src[0]);
+        vsapi->freeFrame(cache->entries[i].src[1]);
+        vsapi->freeFrame(cache->entries[i].frame);
+    }
+
+    free(cache->entries);
+    free(cache);
+}
+
+bool frameCacheParseArg(const VSMap *in, VSMap *out, const char *name, FrameCache **cache, const VSAPI *vsapi) {
+    char msg[80];
+    int err;
+
+    *cache = NULL;
+
+    int cache_size = int64ToIntS(vsapi->propGetInt(in, "cache", 0, &err));
+    if (err)
+        cache_size = 0;
+
+    if (cache_size < 0 || cache_size > 64) {
+        snprintf(msg, sizeof(msg), "ispc.%s: \"cache\" must be between 0 and 64", name);
+        vsapi->setError(out, msg);
+        return false;
+    }
+
+    if (cache_size == 0)
+        return true;
+
+    *cache = frameCacheCreate(cache_size);
+    if (!*cache) {
+        snprintf(msg, sizeof(msg), "ispc.%s: failed to allocate frame cache", name);
+        vsapi->setError(out, msg);
+        return false;
+    }
+
+    return true;
+}
+
+VSFrameRef *frameCacheTryGet(FrameCache *cache, const VSFrameRef *src1, const VSFrameRef *src2, VSCore *core, const VSAPI *vsapi) {
+    if (!cache)
+        return NULL;
+
+    const uint8_t *planes[2][3];
+    frameCacheKey(src1, planes[0], vsapi);
+    frameCacheKey(src2, planes[1], vsapi);
+
+    const VSFrameRef *cached = NULL;
+    FrameCacheEntry recent = { .src = { NULL, NULL }, .frame = NULL };
+
+    frameCacheAcquire(cache);
+
+    const int i = frameCacheFind(cache, planes);
+    if (i >= 0) {
+        cached = vsapi->cloneFrameRef(cache->entries[i].frame);
+    } else if (cache->recent >= 0) {
+        // compared after releasing the lock, the references keep the frames alive if the entry is evicted meanwhile
+        const FrameCacheEntry *entry = &cache->entries[cache->recent];
+
+        recent.src[0] = vsapi->cloneFrameRef(entry->src[0]);
+        recent.src[1] = vsapi->cloneFrameRef(entry->src[1]);
+        recent.frame = vsapi->cloneFrameRef(entry->frame);
+    }
+
+    frameCacheRelease(cache);
+
+    if (recent.frame) {
+        if (frameCacheEqual(src1, recent.src[0], vsapi) && frameCacheEqual(src2, recent.src[1], vsapi)) {
+            cached = recent.frame;
+            recent.frame = NULL;
+        }
+
+        vsapi->freeFrame(recent.src[0]);
+        vsapi->freeFrame(recent.src[1]);
+        vsapi->freeFrame(recent.frame);
+    }
+
+    frameCacheAcquire(cache);
+
+    if (cached)
+        cache->hits++;
+    else
+        cache->misses++;
+
+    frameCacheRelease(cache);
+
+    if (!cached)
+        return NULL;
+
+    // planes are shared, not copied
+    const VSFormat *fi = vsapi->getFrameFormat(cached);
+    const int pl[] = { 0, 1, 2 };
+    const VSFrameRef *fr[] = { cached, cached, cached };
+    VSFrameRef *dst = vsapi->newVideoFrame2(fi, vsapi->getFrameWidth(cached, 0), vsapi->getFrameHeight(cached, 0), fr, pl, src1, core);
+
+    vsapi->freeFrame(cached);
+
+    frameCacheSetProps(cache, dst, vsapi);
+    return dst;
+}
+
+void frameCacheInsert(FrameCache *cache, const VSFrameRef *src1, const VSFrameRef *src2, VSFrameRef *frame, const VSAPI *vsapi) {
+    if (!cache)
+        return;
+
+    frameCacheSetProps(cache, frame, vsapi);
+
+    FrameCacheEntry added = { .src = { vsapi->cloneFrameRef(src1), vsapi->cloneFrameRef(src2) },
+                              .frame = vsapi->cloneFrameRef(frame) };
+    frameCacheKey(src1, added.planes[0], vsapi);
+    frameCacheKey(src2, added.planes[1], vsapi);
+
+    FrameCacheEntry evicted = { .src = { NULL, NULL }, .frame = NULL };
+
+    frameCacheAcquire(cache);
+
+    // another thread may have produced the same output meanwhile
+    if (frameCacheFind(cache, added.planes) >= 0) {
+        evicted = added;
+    } else {
+        evicted = cache->entries[cache->next];
+        cache->entries[cache->next] = added;
+        cache->recent = cache->next;
+
+        cache->next = (cache->next + 1) % cache->capacity;
+    }
+
+    frameCacheRelease(cache);
+
+    vsapi->freeFrame(evicted.src[0]);
+    vsapi->freeFrame(evicted.src[1]);
+    vsapi->freeFrame(evicted.frame);
+}
@@ -0,0 +1,51 @@
+#ifndef ISPC_FRAME_CACHE_H
+#define ISPC_FRAME_CACHE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "VapourSynth.h"
+#include "VSHelper.h"
+
+// Bounded cache of output frames keyed by the input frames, which lets two-clip filters skip recomputation
+// when the inputs repeat, e.g. on runs of identical frames in animation.
+// Each entry holds references to its input frames, so their plane buffers can neither be freed nor written
+// while cached. A lookup first scans the entries (at most capacity) for the same plane pointers, which catches frames
+// repeated by std.Loop, std.DuplicateFrames or frame rate conversion without reading any sample.
+// Otherwise the inputs are compared row by row against those of the most recently inserted entry, which catches
+// identical frames decoded separately. The comparison stops at the first differing row, so a changed frame
+// usually costs a few rows, while a repeated one costs one read of both pairs instead of the operation.
+// Shared by all getFrame calls of a filter instance, guarded by a spin lock that is never held during a comparison.
+
+typedef struct {
+    const VSFrameRef *src[2]; // keeps the buffers behind planes alive
+    const uint8_t *planes[2][3];
+    const VSFrameRef *frame;
+} FrameCacheEntry;
+
+typedef struct {
+    FrameCacheEntry *entries;
+    int capacity;
+    int next; // round-robin replacement
+    int recent; // most recently inserted entry, -1 while empty
+    atomic_flag lock;
+    int64_t hits, misses;
+} FrameCache;
+
+extern FrameCache *frameCacheCreate(int capacity);
+extern void frameCacheFree(FrameCache *cache, const VSAPI *vsapi);
+
+// Reads the optional "cache" argument of the filter name into *cache, NULL when disabled.
+// On failure the error is set on out and false is returned, the caller still owns its nodes.
+extern bool frameCacheParseArg(const VSMap *in, VSMap *out, const char *name, FrameCache **cache, const VSAPI *vsapi);
+
+// Returns a new frame sharing the planes of the output cached for src1 and src2, with properties from src1
+// and the counters set, or NULL on a miss. Both outcomes are counted. A NULL cache always misses without counting.
+extern VSFrameRef *frameCacheTryGet(FrameCache *cache, const VSFrameRef *src1, const VSFrameRef *src2, VSCore *core, const VSAPI *vsapi);
+
+// Sets the counters on frame and stores it as the output for src1 and src2. Does nothing for a NULL cache.
+extern void frameCacheInsert(FrameCache *cache, const VSFrameRef *src1, const VSFrameRef *src2, VSFrameRef *frame, const VSAPI *vsapi);
+
+#endif // ISPC_FRAME_CACHE_H
@@ -1,14 +1,30 @@
 #include "VapourSynth.h"
 #include "VSHelper.h"
 
+#include "bilateral.h"
+#include "box_blur.h"
+#include "colorspace.h"
+#include "edge.h"
 #include "element_wise.h"
+#include "metrics.h"
+#include "resize.h"
 
 VS_EXTERNAL_API(void) VapourSynthPluginInit(VSConfigPlugin configFunc, VSRegisterFunction registerFunc, VSPlugin *plugin) {
     configFunc("com.wolframrhodium.ispc", "ispc", "ISPC filters", VAPOURSYNTH_API_VERSION, 1, plugin);
     registerFunc("Binarize", "clip:clip;threshold:float[]:opt;v0:float[]:opt;v1:float[]:opt;planes:int[]:opt;", binarizeCreate, 0, plugin);
     registerFunc("Invert", "clip:clip;planes:int[]:opt;", invertCreate, 0, plugin);
-    registerFunc("MakeDiff", "clipa:clip;clipb:clip;planes:int[]:opt;", makeDiffCreate, 0, plugin);
-    registerFunc("MergeDiff", "clipa:clip;clipb:clip;planes:int[]:opt;", mergeDiffCreate, 0, plugin);
-    registerFunc("Merge", "clipa:clip;clipb:clip;weight:float[]:opt;", mergeCreate, 0, plugin);
+    registerFunc("MakeDiff", "clipa:clip;clipb:clip;planes:int[]:opt;cache:int:opt;format:int:opt;", makeDiffCreate, 0, plugin);
+    registerFunc("MergeDiff", "clipa:clip;clipb:clip;planes:int[]:opt;cache:int:opt;format:int:opt;", mergeDiffCreate, 0, plugin);
+    registerFunc("Merge", "clipa:clip;clipb:clip;weight:float[]:opt;cache:int:opt;", mergeCreate, 0, plugin);
     registerFunc("Limiter", "clip:clip;min:float[]:opt;max:float[]:opt;planes:int[]:opt;", limiterCreate, 0, plugin);
+    registerFunc("Levels", "clip:clip;min_in:float[]:opt;max_in:float[]:opt;gamma:float[]:opt;min_out:float[]:opt;max_out:float[]:opt;planes:int[]:opt;", levelsCreate, 0, plugin);
+    registerFunc("BoxBlur", "clip:clip;hradius:int:opt;vradius:int:opt;hpasses:int:opt;vpasses:int:opt;planes:int[]:opt;", boxBlurCreate, 0, plugin);
+    registerFunc("Resize", "clip:clip;width:int;height:int;kernel:data:opt;src_left:float:opt;src_top:float:opt;src_width:float:opt;src_height:float:opt;", resizeCreate, 0, plugin);
+    registerFunc("Matrix", "clip:clip;matrix:data:opt;coeffs:float[]:opt;offsets:float[]:opt;format:int:opt;full_in:int:opt;full_out:int:opt;", matrixCreate, 0, plugin);
+    registerFunc("Transfer", "clip:clip;transfer_in:data;transfer_out:data;", transferCreate, 0, plugin);
+    registerFunc("Sobel", "clip:clip;planes:int[]:opt;scale:float:opt;approximate:int:opt;", sobelCreate, 0, plugin);
+    registerFunc("Prewitt", "clip:clip;planes:int[]:opt;scale:float:opt;approximate:int:opt;", prewittCreate, 0, plugin);
+    registerFunc("Hysteresis", "clipa:clip;clipb:clip;planes:int[]:opt;", hysteresisCreate, 0, plugin);
+    registerFunc("Metrics", "reference:clip;distorted:clip;metrics:data[]:opt;planes:int[]:opt;", metricsCreate, 0, plugin);
+    registerFunc("Bilateral", "clip:clip;sigma_s:float:opt;sigma_r:float:opt;subsample:int:opt;planes:int[]:opt;", bilateralCreate, 0, plugin);
 }
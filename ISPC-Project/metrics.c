@@ -0,0 +1,220 @@
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "metrics.h"
+#include "metrics_ispc.h" // generated by ispc
+
+// Metrics
+static void VS_CC metricsInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    MetricsData *d = (MetricsData *) * instanceData;
+    vsapi->setVideoInfo(d->vi, 1, node);
+}
+
+static const VSFrameRef *VS_CC metricsGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    MetricsData *d = (MetricsData *) * instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node1, frameCtx);
+        vsapi->requestFrameFilter(n, d->node2, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrameRef *src1 = vsapi->getFrameFilter(n, d->node1, frameCtx);
+        const VSFrameRef *src2 = vsapi->getFrameFilter(n, d->node2, frameCtx);
+
+        // 5 * width column sums of the SSIM kernels, int32 for 8 bit input and double otherwise
+        void *sums = NULL;
+        if (d->ssim) {
+            sums = scratchPoolAcquire(d->pool);
+            if (!sums) {
+                vsapi->freeFrame(src1);
+                vsapi->freeFrame(src2);
+                vsapi->setFilterError("ispc.Metrics: failed to allocate scratch buffer", frameCtx);
+                return 0;
+            }
+        }
+
+        // the distorted clip is passed through
+        VSFrameRef *dst = vsapi->copyFrame(src2, core);
+        VSMap *props = vsapi->getFramePropsRW(dst);
+
+        // values inherited from an upstream Metrics would otherwise be appended to
+        vsapi->propDeleteKey(props, "ISPCPSNR");
+        vsapi->propDeleteKey(props, "ISPCSSIM");
+
+        const VSFormat *fi = d->vi->format;
+        const double peak = (fi->sampleType == stInteger) ? (double)((1 << fi->bitsPerSample) - 1) : 1.0;
+
+        for (int plane = 0; plane < fi->numPlanes; plane++) {
+            if (d->process[plane]) {
+                int stride = vsapi->getStride(src1, plane) / fi->bytesPerSample;
+                int height = vsapi->getFrameHeight(src1, plane);
+                int width = vsapi->getFrameWidth(src1, plane);
+                const uint8_t * VS_RESTRICT srcp1 = vsapi->getReadPtr(src1, plane);
+                const uint8_t * VS_RESTRICT srcp2 = vsapi->getReadPtr(src2, plane);
+
+                double sse = 0.0, ssim = 0.0;
+
+                if (fi->sampleType == stInteger) {
+                    if (fi->bytesPerSample == 1) {
+                        if (d->psnr)
+                            sse = sse_i8(srcp1, srcp2, width, height, stride);
+                        if (d->ssim)
+                            ssim = ssim_i8(srcp1, srcp2, sums, width, height, stride, (float)peak);
+
+                    } else if (fi->bytesPerSample == 2) {
+                        if (d->psnr)
+                            sse = sse_i16((const uint16_t *)srcp1, (const uint16_t *)srcp2, width, height, stride);
+                        if (d->ssim)
+                            ssim = ssim_i16((const uint16_t *)srcp1, (const uint16_t *)srcp2, sums, width, height, stride, (float)peak);
+                    }
+                } else if (fi->sampleType == stFloat) {
+                    if (fi->bytesPerSample == 4) {
+                        if (d->psnr)
+                            sse = sse_f32((const float *)srcp1, (const float *)srcp2, width, height, stride);
+                        if (d->ssim)
+                            ssim = ssim_f32((const float *)srcp1, (const float *)srcp2, sums, width, height, stride, (float)peak);
+                    }
+                }
+
+                // identical planes have an infinite PSNR
+                if (d->psnr) {
+                    const double mse = sse / ((double)width * height);
+                    vsapi->propSetFloat(props, "ISPCPSNR", (mse > 0.0) ? 10.0 * log10(peak * peak / mse) : INFINITY, paAppend);
+                }
+
+                if (d->ssim)
+                    vsapi->propSetFloat(props, "ISPCSSIM", ssim, paAppend);
+            } else {
+                // one entry per plane, so that the index of a value is always its plane
+                if (d->psnr)
+                    vsapi->propSetFloat(props, "ISPCPSNR", NAN, paAppend);
+                if (d->ssim)
+                    vsapi->propSetFloat(props, "ISPCSSIM", NAN, paAppend);
+            }
+        }
+
+        scratchPoolRelease(d->pool, sums);
+
+        vsapi->freeFrame(src1);
+        vsapi->freeFrame(src2);
+        return dst;
+    }
+
+    return 0;
+}
+
+static void VS_CC metricsFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    MetricsData *d = (MetricsData *)instanceData;
+    vsapi->freeNode(d->node1);
+    vsapi->freeNode(d->node2);
+    scratchPoolFree(d->pool);
+    free(d);
+}
+
+void VS_CC metricsCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    MetricsData d;
+
+    d.node1 = vsapi->propGetNode(in, "reference", 0, NULL);
+    d.node2 = vsapi->propGetNode(in, "distorted", 0, NULL);
+    d.vi = vsapi->getVideoInfo(d.node2);
+
+    if (!isConstantFormat(d.vi) || !isSameFormat(d.vi, vsapi->getVideoInfo(d.node1))) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        vsapi->setError(out, "ispc.Metrics: both clips must have constant format and dimensions, and the same format and dimensions");
+        return;
+    }
+
+    if (d.vi->format->colorFamily == cmCompat) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        vsapi->setError(out, "ispc.Metrics: compat formats are not supported");
+        return;
+    }
+
+    if ((d.vi->format->sampleType == stInteger && d.vi->format->bytesPerSample != 1 && d.vi->format->bytesPerSample != 2)
+        || (d.vi->format->sampleType == stFloat && d.vi->format->bytesPerSample != 4)) {
+        vsapi->freeNode(d.node1);
+        vsapi->freeNode(d.node2);
+        vsapi->setError(out, "ispc.Metrics: only 8-16 bit integer and 32 bit float input supported");
+        return;
+    }
+
+    const int num_metrics = vsapi->propNumElements(in, "metrics");
+
+    d.psnr = (num_metrics <= 0);
+    d.ssim = (num_metrics <= 0);
+
+    for (int i = 0; i < num_metrics; i++) {
+        const char *metric = vsapi->propGetData(in, "metrics", i, NULL);
+
+        if (strcmp(metric, "psnr") == 0) {
+            d.psnr = true;
+        } else if (strcmp(metric, "ssim") == 0) {
+            d.ssim = true;
+        } else {
+            vsapi->freeNode(d.node1);
+            vsapi->freeNode(d.node2);
+            vsapi->setError(out, "ispc.Metrics: \"metrics\" must contain only \"psnr\" or \"ssim\"");
+            return;
+        }
+    }
+
+    int num_planes = d.vi->format->numPlanes;
+    const int m = vsapi->propNumElements(in, "planes");
+
+    for (int i = 0; i < 3; i++)
+        d.process[i] = (m <= 0);
+
+    for (int i = 0; i < m; i++) {
+        int plane = int64ToIntS(vsapi->propGetInt(in, "planes", i, NULL));
+
+        if (plane < 0 || plane >= num_planes) {
+            vsapi->freeNode(d.node1);
+            vsapi->freeNode(d.node2);
+            vsapi->setError(out, "ispc.Metrics: plane index out of range");
+            return;
+        }
+
+        if (d.process[plane]) {
+            vsapi->freeNode(d.node1);
+            vsapi->freeNode(d.node2);
+            vsapi->setError(out, "ispc.Metrics: plane specified twice");
+            return;
+        }
+
+        d.process[plane] = true;
+    }
+
+    // SSIM windows are 8x8
+    if (d.ssim) {
+        for (int plane = 0; plane < num_planes; plane++) {
+            const int ssw = plane ? d.vi->format->subSamplingW : 0;
+            const int ssh = plane ? d.vi->format->subSamplingH : 0;
+
+            if (d.process[plane] && ((d.vi->width >> ssw) < 8 || (d.vi->height >> ssh) < 8)) {
+                vsapi->freeNode(d.node1);
+                vsapi->freeNode(d.node2);
+                vsapi->setError(out, "ispc.Metrics: planes must be at least 8x8 for \"ssim\"");
+                return;
+            }
+        }
+    }
+
+    // plane 0 is the widest plane
+    d.pool = NULL;
+    if (d.ssim) {
+        d.pool = scratchPoolCreate(5 * (size_t)d.vi->width * sizeof(double));
+        if (!d.pool) {
+            vsapi->freeNode(d.node1);
+            vsapi->freeNode(d.node2);
+            vsapi->setError(out, "ispc.Metrics: failed to allocate scratch pool");
+            return;
+        }
+    }
+
+    MetricsData * const data = malloc(sizeof(d));
+    *data = d;
+
+    vsapi->createFilter(in, out, "Metrics", metricsInit, metricsGetFrame, metricsFree, fmParallel, 0, data, core);
+}
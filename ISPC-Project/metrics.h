@@ -0,0 +1,24 @@
+#ifndef ISPC_METRICS_H
+#define ISPC_METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "VapourSynth.h"
+#include "VSHelper.h"
+
+#include "scratch_pool.h"
+
+typedef struct {
+    VSNodeRef *node1; // reference
+    VSNodeRef *node2; // distorted
+    const VSVideoInfo *vi;
+    bool process[3];
+    bool psnr, ssim;
+    ScratchPool *pool; // SSIM column sums, NULL without SSIM
+} MetricsData;
+
+extern void VS_CC metricsCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
+
+#endif // ISPC_METRICS_H
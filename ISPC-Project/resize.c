@@ -0,0 +1,320 @@
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "resize.h"
+#include "resize_ispc.h" // generated by ispc
+
+// M_PI is not part of ISO C
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Resize
+static double sinc(double x) {
+    if (x == 0.0)
+        return 1.0;
+
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+static double kernelSupport(ResizeKernel kernel) {
+    switch (kernel) {
+    case kBilinear:
+        return 1.0;
+    case kBicubic:
+    case kSpline16:
+        return 2.0;
+    case kLanczos:
+    case kSpline36:
+        return 3.0;
+    }
+
+    return 0.0;
+}
+
+static double kernelWeight(ResizeKernel kernel, double x) {
+    x = fabs(x);
+
+    switch (kernel) {
+    case kBilinear:
+        return (x < 1.0) ? 1.0 - x : 0.0;
+
+    case kBicubic: { // Catmull-Rom, b = 0, c = 0.5
+        const double b = 0.0, c = 0.5;
+
+        if (x < 1.0)
+            return ((12.0 - 9.0 * b - 6.0 * c) * x * x * x + (-18.0 + 12.0 * b + 6.0 * c) * x * x + (6.0 - 2.0 * b)) / 6.0;
+        else if (x < 2.0)
+            return ((-b - 6.0 * c) * x * x * x + (6.0 * b + 30.0 * c) * x * x + (-12.0 * b - 48.0 * c) * x + (8.0 * b + 24.0 * c)) / 6.0;
+        else
+            return 0.0;
+    }
+
+    case kLanczos:
+        return (x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+
+    case kSpline16:
+        if (x < 1.0)
+            return ((x - 9.0 / 5.0) * x - 1.0 / 5.0) * x + 1.0;
+        else if (x < 2.0)
+            return ((-1.0 / 3.0 * (x - 1.0) + 4.0 / 5.0) * (x - 1.0) - 7.0 / 15.0) * (x - 1.0);
+        else
+            return 0.0;
+
+    case kSpline36:
+        if (x < 1.0)
+            return ((13.0 / 11.0 * x - 453.0 / 209.0) * x - 3.0 / 209.0) * x + 1.0;
+        else if (x < 2.0)
+            return ((-6.0 / 11.0 * (x - 1.0) + 270.0 / 209.0) * (x - 1.0) - 156.0 / 209.0) * (x - 1.0);
+        else if (x < 3.0)
+            return ((1.0 / 11.0 * (x - 2.0) - 45.0 / 209.0) * (x - 2.0) + 26.0 / 209.0) * (x - 2.0);
+        else
+            return 0.0;
+    }
+
+    return 0.0;
+}
+
+// Output sample x is centred on input position x * scale + offset.
+// Taps falling outside of the input are folded onto the edge samples, so every window lies inside the input.
+// With tap_major, coefficients are laid out as coeffs[k * dst_size + x], otherwise as coeffs[x * taps + k].
+static bool buildCoeffs(ResizeCoeffs *c, ResizeKernel kernel, int src_size, int dst_size, double scale, double offset, bool tap_major) {
+    const double filter_scale = VSMAX(scale, 1.0);
+    const double radius = kernelSupport(kernel) * filter_scale;
+    const int full_taps = (int)ceil(2.0 * radius);
+
+    c->taps = VSMIN(full_taps, src_size);
+    c->start = malloc(dst_size * sizeof(int32_t));
+    c->coeffs = calloc((size_t)dst_size * c->taps, sizeof(float));
+    double *weights = malloc(full_taps * sizeof(double));
+
+    if (!c->start || !c->coeffs || !weights) {
+        free(weights);
+        return false;
+    }
+
+    for (int x = 0; x < dst_size; x++) {
+        const double center = x * scale + offset;
+        const int start = (int)floor(center - radius) + 1;
+        const int clamped_start = VSMAX(VSMIN(start, src_size - c->taps), 0);
+
+        double total = 0.0;
+        for (int k = 0; k < full_taps; k++) {
+            weights[k] = kernelWeight(kernel, (start + k - center) / filter_scale);
+            total += weights[k];
+        }
+
+        for (int k = 0; k < full_taps; k++) {
+            const int pos = VSMAX(VSMIN(start + k, src_size - 1), 0) - clamped_start;
+            const size_t index = tap_major ? (size_t)pos * dst_size + x : (size_t)x * c->taps + pos;
+
+            c->coeffs[index] += (float)(weights[k] / total);
+        }
+
+        c->start[x] = clamped_start;
+    }
+
+    free(weights);
+    return true;
+}
+
+static void VS_CC resizeInit(VSMap *in, VSMap *out, void **instanceData, VSNode *node, VSCore *core, const VSAPI *vsapi) {
+    ResizeData *d = (ResizeData *) * instanceData;
+    vsapi->setVideoInfo(&d->out_vi, 1, node);
+}
+
+static const VSFrameRef *VS_CC resizeGetFrame(int n, int activationReason, void **instanceData, void **frameData, VSFrameContext *frameCtx, VSCore *core, const VSAPI *vsapi) {
+    ResizeData *d = (ResizeData *) * instanceData;
+
+    if (activationReason == arInitial) {
+        vsapi->requestFrameFilter(n, d->node, frameCtx);
+    } else if (activationReason == arAllFramesReady) {
+        const VSFrameRef *src = vsapi->getFrameFilter(n, d->node, frameCtx);
+
+        // plane 0 is the widest plane of both frames
+        float *row = scratchPoolAcquire(d->pool);
+        if (!row) {
+            vsapi->freeFrame(src);
+            vsapi->setFilterError("ispc.Resize: failed to allocate scratch buffer", frameCtx);
+            return 0;
+        }
+
+        float *sum = row + d->vi->width;
+
+        VSFrameRef *dst = vsapi->newVideoFrame(d->out_vi.format, d->out_vi.width, d->out_vi.height, src, core);
+
+        for (int plane = 0; plane < d->vi->format->numPlanes; plane++) {
+            int src_stride = vsapi->getStride(src, plane) / d->vi->format->bytesPerSample;
+            int src_width = vsapi->getFrameWidth(src, plane);
+            int dst_stride = vsapi->getStride(dst, plane) / d->vi->format->bytesPerSample;
+            int dst_height = vsapi->getFrameHeight(dst, plane);
+            int dst_width = vsapi->getFrameWidth(dst, plane);
+            const uint8_t * VS_RESTRICT srcp = vsapi->getReadPtr(src, plane);
+            uint8_t * VS_RESTRICT dstp = vsapi->getWritePtr(dst, plane);
+            const ResizeCoeffs *h = &d->h[plane];
+            const ResizeCoeffs *v = &d->v[plane];
+
+            if (d->vi->format->sampleType == stInteger) {
+                if (d->vi->format->bytesPerSample == 1) {
+                    resize_i8(srcp, dstp, row, sum, src_width, src_stride, dst_width, dst_height, dst_stride, 
+                        h->taps, h->start, h->coeffs, v->taps, v->start, v->coeffs);
+
+                } else if (d->vi->format->bytesPerSample == 2) {
+                    const float peak = (float)((1 << d->vi->format->bitsPerSample) - 1);
+
+                    resize_i16((const uint16_t *)srcp, (uint16_t *)dstp, row, sum, src_width, src_stride, dst_width, dst_height, dst_stride, 
+                        h->taps, h->start, h->coeffs, v->taps, v->start, v->coeffs, peak);
+                }
+            } else if (d->vi->format->sampleType == stFloat) {
+                if (d->vi->format->bytesPerSample == 4) {
+                    resize_f32((const float *)srcp, (float *)dstp, row, src_width, src_stride, dst_width, dst_height, dst_stride, 
+                        h->taps, h->start, h->coeffs, v->taps, v->start, v->coeffs);
+                }
+            }
+        }
+
+        scratchPoolRelease(d->pool, row);
+
+        vsapi->freeFrame(src);
+        return dst;
+    }
+
+    return 0;
+}
+
+static void resizeFreeCoeffs(ResizeData *d) {
+    for (int i = 0; i < 3; i++) {
+        free(d->h[i].start);
+        free(d->h[i].coeffs);
+        free(d->v[i].start);
+        free(d->v[i].coeffs);
+    }
+}
+
+static void VS_CC resizeFree(void *instanceData, VSCore *core, const VSAPI *vsapi) {
+    ResizeData *d = (ResizeData *)instanceData;
+    vsapi->freeNode(d->node);
+    resizeFreeCoeffs(d);
+    scratchPoolFree(d->pool);
+    free(d);
+}
+
+void VS_CC resizeCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi) {
+    ResizeData d;
+
+    d.node = vsapi->propGetNode(in, "clip", 0, NULL);
+    d.vi = vsapi->getVideoInfo(d.node);
+
+    if (!isConstantFormat(d.vi) || d.vi->format->colorFamily == cmCompat) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Resize: only constant format input supported, and compat formats are not supported");
+        return;
+    }
+
+    if ((d.vi->format->sampleType == stInteger && d.vi->format->bytesPerSample != 1 && d.vi->format->bytesPerSample != 2)
+        || (d.vi->format->sampleType == stFloat && d.vi->format->bytesPerSample != 4)) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Resize: only 8-16 bit integer and 32 bit float input supported");
+        return;
+    }
+
+    int err;
+
+    d.out_vi = *d.vi;
+    d.out_vi.width = int64ToIntS(vsapi->propGetInt(in, "width", 0, NULL));
+    d.out_vi.height = int64ToIntS(vsapi->propGetInt(in, "height", 0, NULL));
+
+    const int ssw = d.vi->format->subSamplingW;
+    const int ssh = d.vi->format->subSamplingH;
+
+    if (d.out_vi.width <= 0 || d.out_vi.height <= 0 
+        || (d.out_vi.width % (1 << ssw)) != 0 || (d.out_vi.height % (1 << ssh)) != 0) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Resize: output dimensions must be positive and multiples of the subsampling");
+        return;
+    }
+
+    ResizeKernel kernel = kBicubic;
+    const char *kernel_name = vsapi->propGetData(in, "kernel", 0, &err);
+    if (!err) {
+        if (strcmp(kernel_name, "bilinear") == 0) {
+            kernel = kBilinear;
+        } else if (strcmp(kernel_name, "bicubic") == 0) {
+            kernel = kBicubic;
+        } else if (strcmp(kernel_name, "lanczos") == 0) {
+            kernel = kLanczos;
+        } else if (strcmp(kernel_name, "spline16") == 0) {
+            kernel = kSpline16;
+        } else if (strcmp(kernel_name, "spline36") == 0) {
+            kernel = kSpline36;
+        } else {
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Resize: \"kernel\" must be one of \"bilinear\", \"bicubic\", \"lanczos\", \"spline16\" or \"spline36\"");
+            return;
+        }
+    }
+
+    double src_left = vsapi->propGetFloat(in, "src_left", 0, &err);
+    if (err)
+        src_left = 0.0;
+
+    double src_top = vsapi->propGetFloat(in, "src_top", 0, &err);
+    if (err)
+        src_top = 0.0;
+
+    double src_width = vsapi->propGetFloat(in, "src_width", 0, &err);
+    if (err)
+        src_width = d.vi->width;
+
+    double src_height = vsapi->propGetFloat(in, "src_height", 0, &err);
+    if (err)
+        src_height = d.vi->height;
+
+    if (src_width <= 0.0 || src_height <= 0.0) {
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Resize: \"src_width\" and \"src_height\" must be positive");
+        return;
+    }
+
+    const double scale_w = src_width / d.out_vi.width;
+    const double scale_h = src_height / d.out_vi.height;
+
+    memset(d.h, 0, sizeof(d.h));
+    memset(d.v, 0, sizeof(d.v));
+
+    for (int plane = 0; plane < d.vi->format->numPlanes; plane++) {
+        const int sw = (plane > 0) ? ssw : 0;
+        const int sh = (plane > 0) ? ssh : 0;
+        const double fw = 1 << sw;
+        const double fh = 1 << sh;
+
+        // horizontally subsampled YUV chroma is left-aligned (MPEG-2), everything else is centred
+        const double offset_w = (sw > 0 && d.vi->format->colorFamily == cmYUV) 
+            ? (0.5 * scale_w - 0.5 + src_left) / fw 
+            : src_left / fw + 0.5 * scale_w - 0.5;
+        const double offset_h = src_top / fh + 0.5 * scale_h - 0.5;
+
+        if (!buildCoeffs(&d.h[plane], kernel, d.vi->width >> sw, d.out_vi.width >> sw, scale_w, offset_w, true) 
+            || !buildCoeffs(&d.v[plane], kernel, d.vi->height >> sh, d.out_vi.height >> sh, scale_h, offset_h, false)) {
+            resizeFreeCoeffs(&d);
+            vsapi->freeNode(d.node);
+            vsapi->setError(out, "ispc.Resize: failed to allocate coefficient tables");
+            return;
+        }
+    }
+
+    d.pool = scratchPoolCreate(((size_t)d.vi->width + d.out_vi.width) * sizeof(float));
+    if (!d.pool) {
+        resizeFreeCoeffs(&d);
+        vsapi->freeNode(d.node);
+        vsapi->setError(out, "ispc.Resize: failed to allocate scratch pool");
+        return;
+    }
+
+    ResizeData * const data = malloc(sizeof(d));
+    *data = d;
+
+    vsapi->createFilter(in, out, "Resize", resizeInit, resizeGetFrame, resizeFree, fmParallel, 0, data, core);
+}
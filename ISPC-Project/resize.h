@@ -0,0 +1,38 @@
+#ifndef ISPC_RESIZE_H
+#define ISPC_RESIZE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "VapourSynth.h"
+#include "VSHelper.h"
+
+#include "scratch_pool.h"
+
+typedef enum ResizeKernel {
+    kBilinear = 0,
+    kBicubic = 1,
+    kLanczos = 2,
+    kSpline16 = 3,
+    kSpline36 = 4
+} ResizeKernel;
+
+// per-dimension coefficient table, taps contiguous input samples per output sample
+typedef struct {
+    int taps;
+    int32_t *start; // first input sample of each output sample
+    float *coeffs;
+} ResizeCoeffs;
+
+typedef struct {
+    VSNodeRef *node;
+    const VSVideoInfo *vi;
+    VSVideoInfo out_vi;
+    ResizeCoeffs h[3], v[3];
+    ScratchPool *pool; // row and sum buffers of the kernels
+} ResizeData;
+
+extern void VS_CC resizeCreate(const VSMap *in, VSMap *out, void *userData, VSCore *core, const VSAPI *vsapi);
+
+#endif // ISPC_RESIZE_H
@@ -0,0 +1,69 @@
+#include <stdlib.h>
+
+#include "scratch_pool.h"
+
+static void scratchPoolLock(ScratchPool *pool) {
+    while (atomic_flag_test_and_set_explicit(&pool->lock, memory_order_acquire))
+        ;
+}
+
+static void scratchPoolUnlock(ScratchPool *pool) {
+    atomic_flag_clear_explicit(&pool->lock, memory_order_release);
+}
+
+ScratchPool *scratchPoolCreate(size_t size) {
+    ScratchPool *pool = malloc(sizeof(ScratchPool));
+    if (!pool)
+        return NULL;
+
+    *pool = (ScratchPool){ .size = size, .free_list = NULL, .lock = ATOMIC_FLAG_INIT };
+
+    return pool;
+}
+
+void scratchPoolFree(ScratchPool *pool) {
+    if (!pool)
+        return;
+
+    ScratchBuffer *buffer = pool->free_list;
+
+    while (buffer) {
+        ScratchBuffer *next = buffer->next;
+        free(buffer);
+        buffer = next;
+    }
+
+    free(pool);
+}
+
+void *scratchPoolAcquire(ScratchPool *pool) {
+    scratchPoolLock(pool);
+
+    ScratchBuffer *buffer = pool->free_list;
+    if (buffer)
+        pool->free_list = buffer->next;
+
+    scratchPoolUnlock(pool);
+
+    if (!buffer) {
+        buffer = malloc(sizeof(ScratchBuffer) + pool->size);
+        if (!buffer)
+            return NULL;
+    }
+
+    return buffer->data;
+}
+
+void scratchPoolRelease(ScratchPool *pool, void *data) {
+    if (!data)
+        return;
+
+    ScratchBuffer *buffer = (ScratchBuffer *)((char *)data - offsetof(ScratchBuffer, data));
+
+    scratchPoolLock(pool);
+
+    buffer->next = pool->free_list;
+    pool->free_list = buffer;
+
+    scratchPoolUnlock(pool);
+}
@@ -0,0 +1,32 @@
+#ifndef ISPC_SCRATCH_POOL_H
+#define ISPC_SCRATCH_POOL_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-instance pool of equally sized scratch buffers for the temporary arrays of the kernels.
+// A buffer is taken for the duration of one getFrame call and returned afterwards,
+// so the pool grows to at most one buffer per thread working on the filter and nothing is allocated per frame.
+// Guarded by a spin lock, which is only held to push or pop a list node.
+
+typedef struct ScratchBuffer {
+    struct ScratchBuffer *next;
+    max_align_t data[]; // size bytes
+} ScratchBuffer;
+
+typedef struct {
+    size_t size;
+    ScratchBuffer *free_list;
+    atomic_flag lock;
+} ScratchPool;
+
+extern ScratchPool *scratchPoolCreate(size_t size);
+extern void scratchPoolFree(ScratchPool *pool);
+
+// Returns size bytes aligned for any type, or NULL if allocation fails
+extern void *scratchPoolAcquire(ScratchPool *pool);
+extern void scratchPoolRelease(ScratchPool *pool, void *data);
+
+#endif // ISPC_SCRATCH_POOL_H